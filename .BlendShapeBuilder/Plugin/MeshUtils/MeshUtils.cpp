@@ -140,6 +140,159 @@ bool GenerateTangentsPoly(
     return genTangSpaceDefault(&tctx) != 0;
 }
 
+struct TSpaceComponentContext
+{
+    float4 *dst;
+    const float3 *points;
+    const float3 *normals;
+    const float2 *uv;
+    const int *indices;
+    const int *faces;
+    int num_faces;
+
+    static TSpaceComponentContext* get(const SMikkTSpaceContext *tctx)
+    {
+        return reinterpret_cast<TSpaceComponentContext*>(tctx->m_pUserData);
+    }
+    int index(int iface, int ivtx) const { return indices[faces[iface] * 3 + ivtx]; }
+
+    static int getNumFaces(const SMikkTSpaceContext *tctx) { return get(tctx)->num_faces; }
+    static int getCount(const SMikkTSpaceContext *, int) { return 3; }
+
+    static void getPosition(const SMikkTSpaceContext *tctx, float *o_pos, int iface, int ivtx)
+    {
+        auto *_this = get(tctx);
+        (float3&)*o_pos = _this->points[_this->index(iface, ivtx)];
+    }
+
+    static void getNormal(const SMikkTSpaceContext *tctx, float *o_normal, int iface, int ivtx)
+    {
+        auto *_this = get(tctx);
+        (float3&)*o_normal = _this->normals[_this->index(iface, ivtx)];
+    }
+
+    static void getTexCoord(const SMikkTSpaceContext *tctx, float *o_tcoord, int iface, int ivtx)
+    {
+        auto *_this = get(tctx);
+        (float2&)*o_tcoord = _this->uv[_this->index(iface, ivtx)];
+    }
+
+    static void setTangent(const SMikkTSpaceContext *tctx, const float* tangent, const float* /*bitangent*/,
+        float /*fMagS*/, float /*fMagT*/, tbool IsOrientationPreserving, int iface, int ivtx)
+    {
+        auto *_this = get(tctx);
+        float sign = (IsOrientationPreserving != 0) ? 1.0f : -1.0f;
+        _this->dst[_this->index(iface, ivtx)] = { tangent[0], tangent[1], tangent[2], sign };
+    }
+};
+
+// mikktspace only shares tangent spaces among triangles connected by vertices of the same position, normal and uv.
+// so running it per connected component (in the original triangle order) gives the same results as running it
+// on the whole mesh. components don't share vertex indices and can be processed in parallel.
+void GenerateTangentsMikkTSpace(float4 *dst,
+    const float3 *points, const float2 *uv, const float3 *normals, const int *indices,
+    int num_triangles, int num_vertices)
+{
+    memset(dst, 0, sizeof(float4) * num_vertices);
+    if (num_triangles <= 0) { return; }
+
+    // weld vertices the same way as mikktspace (exact match of all attributes)
+    RawVector<int> weld_map;
+    weld_map.resize_discard(num_vertices);
+    {
+        SpatialHashGrid grid;
+        grid.build(points, num_vertices);
+        parallel_for(0, num_vertices, [&](int vi) {
+            int r = vi;
+            float3 p = points[vi];
+            grid.eachPointsInSphere(p, 0.0000001f, [&](int i) {
+                if (i < r && points[i] == p && normals[i] == normals[vi] && uv[i] == uv[vi]) {
+                    r = i;
+                }
+            });
+            weld_map[vi] = r;
+        });
+    }
+
+    // union welded vertices of each triangle
+    RawVector<int> parents;
+    parents.resize_discard(num_vertices);
+    std::iota(parents.begin(), parents.end(), 0);
+    auto find_root = [&](int i) {
+        while (parents[i] != i) {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    };
+    for (int ti = 0; ti < num_triangles; ++ti) {
+        int r0 = find_root(weld_map[indices[ti * 3 + 0]]);
+        for (int ci = 1; ci < 3; ++ci) {
+            int r = find_root(weld_map[indices[ti * 3 + ci]]);
+            if (r != r0) {
+                if (r < r0) { std::swap(r, r0); }
+                parents[r] = r0;
+            }
+        }
+    }
+
+    // triangles of each component, keeping the original order
+    RawVector<int> tri_components, component_ids, counts, offsets, faces;
+    tri_components.resize_discard(num_triangles);
+    component_ids.resize(num_vertices, -1);
+    for (int ti = 0; ti < num_triangles; ++ti) {
+        int& c = component_ids[find_root(weld_map[indices[ti * 3]])];
+        if (c == -1) {
+            c = (int)counts.size();
+            counts.push_back(0);
+        }
+        tri_components[ti] = c;
+        ++counts[c];
+    }
+    int num_components = (int)counts.size();
+    offsets.resize_discard(num_components);
+    {
+        int offset = 0;
+        for (int c = 0; c < num_components; ++c) {
+            offsets[c] = offset;
+            offset += counts[c];
+        }
+    }
+    faces.resize_discard(num_triangles);
+    {
+        RawVector<int> pos = offsets;
+        for (int ti = 0; ti < num_triangles; ++ti) {
+            faces[pos[tri_components[ti]]++] = ti;
+        }
+    }
+
+    // larger components first to balance the load
+    RawVector<int> order;
+    order.resize_discard(num_components);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return counts[a] > counts[b]; });
+
+    parallel_for(0, num_components, [&](int i) {
+        int c = order[i];
+        TSpaceComponentContext ctx = { dst, points, normals, uv, indices, &faces[offsets[c]], counts[c] };
+
+        SMikkTSpaceInterface iface;
+        memset(&iface, 0, sizeof(iface));
+        iface.m_getNumFaces = TSpaceComponentContext::getNumFaces;
+        iface.m_getNumVerticesOfFace = TSpaceComponentContext::getCount;
+        iface.m_getPosition = TSpaceComponentContext::getPosition;
+        iface.m_getNormal = TSpaceComponentContext::getNormal;
+        iface.m_getTexCoord = TSpaceComponentContext::getTexCoord;
+        iface.m_setTSpace = TSpaceComponentContext::setTangent;
+
+        SMikkTSpaceContext tctx;
+        memset(&tctx, 0, sizeof(tctx));
+        tctx.m_pInterface = &iface;
+        tctx.m_pUserData = &ctx;
+        genTangSpaceDefault(&tctx);
+    });
+}
+
 
 
 template<int N>
@@ -270,4 +423,76 @@ bool IsEdgeOpened(const IArray<int>& indices, const IArray<int>& counts, const I
     return impl::IsEdgeOpenedImpl(indices, counts, offsets, connection, i0, i1);
 }
 
+
+void GatherAffectedVertices(RawVector<int>& dst, const int *indices, int ngon, const ConnectionData& connection,
+    const int *vertex_indices, int num_vertex_indices)
+{
+    dst.clear();
+    RawVector<char> marks;
+    marks.resize_zeroclear(connection.v2f_counts.size());
+    auto add = [&](int vi) {
+        if (!marks[vi]) {
+            marks[vi] = 1;
+            dst.push_back(vi);
+        }
+    };
+    for (int i = 0; i < num_vertex_indices; ++i) {
+        int vi = vertex_indices[i];
+        add(vi);
+        connection.eachConnectedFaces(vi, [&](int fi, int) {
+            for (int ci = 0; ci < ngon; ++ci) {
+                add(indices[fi * ngon + ci]);
+            }
+        });
+    }
+}
+
+void GenerateNormalsTriangleIndexedPartial(float3 *dst,
+    const float3 *vertices, const int *indices, const ConnectionData& connection,
+    const int *vertex_indices, int num_vertex_indices)
+{
+    // faces are enumerated in the same order as GenerateNormalsTriangleIndexed(). so are the results.
+    parallel_for_blocked(0, num_vertex_indices, 1024, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            int vi = vertex_indices[i];
+            float3 n = float3::zero();
+            connection.eachConnectedFaces(vi, [&](int ti, int) {
+                int ti3 = ti * 3;
+                float3 p0 = vertices[indices[ti3 + 0]];
+                float3 p1 = vertices[indices[ti3 + 1]];
+                float3 p2 = vertices[indices[ti3 + 2]];
+                n += cross(p1 - p0, p2 - p0);
+            });
+            dst[vi] = normalize(n);
+        }
+    });
+}
+
+void GenerateTangentsTriangleIndexedPartial(float4 *dst,
+    const float3 *vertices, const float2 *uv, const float3 *normals, const int *indices, const ConnectionData& connection,
+    const int *vertex_indices, int num_vertex_indices)
+{
+    parallel_for_blocked(0, num_vertex_indices, 1024, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            int vi = vertex_indices[i];
+            float3 tangent = float3::zero();
+            float3 binormal = float3::zero();
+            connection.eachConnectedFaces(vi, [&](int ti, int ii) {
+                int ti3 = ti * 3;
+                int idx[] = { indices[ti3 + 0], indices[ti3 + 1], indices[ti3 + 2] };
+                float3 v[3] = { vertices[idx[0]], vertices[idx[1]], vertices[idx[2]] };
+                float2 u[3] = { uv[idx[0]], uv[idx[1]], uv[idx[2]] };
+                float3 t[3];
+                float3 b[3];
+                compute_triangle_tangent(v, u, t, b);
+
+                int ci = ii - ti3;
+                tangent += t[ci];
+                binormal += b[ci];
+            });
+            dst[vi] = orthogonalize_tangent(tangent, binormal, normals[vi]);
+        }
+    });
+}
+
 } // namespace mu
@@ -10,6 +10,11 @@
 #include "muTLS.h"
 #include "muMisc.h"
 #include "muConcurrency.h"
+#include "muSpatialHash.h"
+#include "muBVH.h"
+#include "muBlendShape.h"
+#include "muCompression.h"
+#include "muDepthBuffer.h"
 
 namespace mu {
 
@@ -21,6 +26,11 @@ bool GenerateTangentsPoly(
     IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
     const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices);
 
+// same results as GenerateTangentsPoly() (mikktspace) for triangles. connected components are processed in parallel.
+void GenerateTangentsMikkTSpace(float4 *dst,
+    const float3 *points, const float2 *uv, const float3 *normals, const int *indices,
+    int num_triangles, int num_vertices);
+
 // PointsIter: indexed_iterator<const float3*, int*> or indexed_iterator_s<const float3*, int*>
 template<class PointsIter>
 void GenerateNormalsPoly(float3 *dst,
@@ -86,6 +96,18 @@ bool OnEdge(const IArray<int>& indices, const IArray<int>& counts, const IArray<
 bool IsEdgeOpened(const IArray<int>& indices, int ngon, const ConnectionData& connection, int i0, int i1);
 bool IsEdgeOpened(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection, int i0, int i1);
 
+// vertices whose normals and tangents depend on the specified vertices (vertices of the faces connected to them)
+void GatherAffectedVertices(RawVector<int>& dst, const int *indices, int ngon, const ConnectionData& connection,
+    const int *vertex_indices, int num_vertex_indices);
+// recompute normals / tangents of the specified vertices only. results are same as GenerateNormalsTriangleIndexed() /
+// GenerateTangentsTriangleIndexed() for these vertices. typically used with GatherAffectedVertices().
+void GenerateNormalsTriangleIndexedPartial(float3 *dst,
+    const float3 *vertices, const int *indices, const ConnectionData& connection,
+    const int *vertex_indices, int num_vertex_indices);
+void GenerateTangentsTriangleIndexedPartial(float4 *dst,
+    const float3 *vertices, const float2 *uv, const float3 *normals, const int *indices, const ConnectionData& connection,
+    const int *vertex_indices, int num_vertex_indices);
+
 template<class Handler>
 void SelectEdge(const IArray<int>& indices, int ngon, const IArray<float3>& vertices,
     const IArray<int>& vertex_indices, const Handler& handler);
@@ -107,6 +129,27 @@ template<class Handler>
 void SelectConnected(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
     const IArray<int>& vertex_indices, const Handler& handler);
 
+// same as above with prebuilt connection to let callers reuse it. costs are proportional to the selected region.
+// connection for SelectHole() must be built with welding (see ConnectionData::buildConnection()).
+template<class Handler>
+void SelectEdge(const IArray<int>& indices, int ngon, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler);
+template<class Handler>
+void SelectEdge(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler);
+template<class Handler>
+void SelectHole(const IArray<int>& indices, int ngon, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler);
+template<class Handler>
+void SelectHole(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler);
+template<class Handler>
+void SelectConnected(const IArray<int>& indices, int ngon, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler);
+template<class Handler>
+void SelectConnected(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler);
+
 
 // ------------------------------------------------------------
 // impl
@@ -92,15 +92,17 @@ inline void BuildWeldMap(
     weld_offsets.resize_discard(n);
     weld_indices.resize_discard(n);
 
+    // find the first vertex at the same position. candidates are limited by hash grid.
+    SpatialHashGrid grid;
+    grid.build(vertices.data(), n);
     parallel_for(0, n, [&](int vi) {
         int r = vi;
         float3 p = vertices[vi];
-        for (int i = 0; i < vi; ++i) {
-            if (length(vertices[i] - p) < 0.0000001f) {
+        grid.eachPointsInSphere(p, 0.0000001f, [&](int i) {
+            if (i < r && length(vertices[i] - p) < 0.0000001f) {
                 r = i;
-                break;
             }
-        }
+        });
         weld_map[vi] = r;
     });
 
@@ -181,15 +183,13 @@ template<class Indices, class Counts, class Offsets>
 class SelectEdgeImpl
 {
 public:
-    SelectEdgeImpl(const Indices& indices_, const Counts& counts_, const Offsets& offsets_, const IArray<float3>& vertices_,
-        const ConnectionData& connection_)
+    SelectEdgeImpl(const Indices& indices_, const Counts& counts_, const Offsets& offsets_, const ConnectionData& connection_)
         : indices(indices_)
         , counts(counts_)
         , offsets(offsets_)
         , connection(connection_)
     {
-        checked.resize(vertices_.size());
-        checked.zeroclear();
+        checked.resize_zeroclear(connection.v2f_counts.size());
     }
 
     template<class Handler>
@@ -291,17 +291,14 @@ private:
 
 
 template<class Handler>
-inline void SelectEdge(const IArray<int>& indices, int ngon, const IArray<float3>& vertices,
+inline void SelectEdge(const IArray<int>& indices, int ngon, const ConnectionData& connection,
     const IArray<int>& vertex_indices, const Handler& handler)
 {
     impl::CountsC counts{ ngon, indices.size() / ngon };
     impl::OffsetsC offsets{ ngon, indices.size() / ngon };
 
-    ConnectionData connection;
-    impl::BuildConnection(connection, indices, counts, vertices);
-
     impl::SelectEdgeImpl<decltype(indices), decltype(counts), decltype(offsets)>
-        impl(indices, counts, offsets, vertices, connection);
+        impl(indices, counts, offsets, connection);
 
     for (int i : vertex_indices) {
         impl.selectEdge(i, handler);
@@ -309,36 +306,46 @@ inline void SelectEdge(const IArray<int>& indices, int ngon, const IArray<float3
 }
 
 template<class Handler>
-inline void SelectEdge(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
+inline void SelectEdge(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection,
     const IArray<int>& vertex_indices, const Handler& handler)
 {
-    ConnectionData connection;
-    impl::BuildConnection(connection, indices, counts, vertices);
-
     impl::SelectEdgeImpl<decltype(indices), decltype(counts), decltype(offsets)>
-        impl(indices, counts, offsets, vertices, connection);
+        impl(indices, counts, offsets, connection);
 
     for (int i : vertex_indices) {
         impl.selectEdge(i, handler);
     }
 }
 
-
 template<class Handler>
-inline void SelectHole(const IArray<int>& indices_, int ngon, const IArray<float3>& vertices,
+inline void SelectEdge(const IArray<int>& indices, int ngon, const IArray<float3>& vertices,
     const IArray<int>& vertex_indices, const Handler& handler)
 {
-    impl::CountsC counts{ ngon, indices_.size() / ngon };
-    impl::OffsetsC offsets{ ngon, indices_.size() / ngon };
+    ConnectionData connection;
+    connection.buildConnection(indices, ngon, vertices);
+    SelectEdge(indices, ngon, connection, vertex_indices, handler);
+}
 
+template<class Handler>
+inline void SelectEdge(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
+    const IArray<int>& vertex_indices, const Handler& handler)
+{
     ConnectionData connection;
-    impl::BuildWeldMap(connection, vertices);
+    impl::BuildConnection(connection, indices, counts, vertices);
+    SelectEdge(indices, counts, offsets, connection, vertex_indices, handler);
+}
 
+
+template<class Handler>
+inline void SelectHole(const IArray<int>& indices_, int ngon, const ConnectionData& connection,
+    const IArray<int>& vertex_indices, const Handler& handler)
+{
+    impl::CountsC counts{ ngon, indices_.size() / ngon };
+    impl::OffsetsC offsets{ ngon, indices_.size() / ngon };
     impl::IndicesW indices{ indices_, connection.weld_map };
-    impl::BuildConnection(connection, indices, counts, vertices);
 
     impl::SelectEdgeImpl<decltype(indices), decltype(counts), decltype(offsets)>
-        impl(indices, counts, offsets, vertices, connection);
+        impl(indices, counts, offsets, connection);
 
     for (int i : vertex_indices) {
         impl.selectHole(i, handler);
@@ -346,36 +353,47 @@ inline void SelectHole(const IArray<int>& indices_, int ngon, const IArray<float
 }
 
 template<class Handler>
-inline void SelectHole(const IArray<int>& indices_, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
+inline void SelectHole(const IArray<int>& indices_, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection,
     const IArray<int>& vertex_indices, const Handler& handler)
 {
-    ConnectionData connection;
-    impl::BuildWeldMap(connection, vertices);
-
     impl::IndicesW indices{ indices_, connection.weld_map };
-    impl::BuildConnection(connection, indices, counts, vertices);
 
     impl::SelectEdgeImpl<decltype(indices), decltype(counts), decltype(offsets)>
-        impl(indices, counts, offsets, vertices, connection);
+        impl(indices, counts, offsets, connection);
 
     for (int i : vertex_indices) {
         impl.selectHole(i, handler);
     }
 }
 
+template<class Handler>
+inline void SelectHole(const IArray<int>& indices, int ngon, const IArray<float3>& vertices,
+    const IArray<int>& vertex_indices, const Handler& handler)
+{
+    ConnectionData connection;
+    connection.buildConnection(indices, ngon, vertices, true);
+    SelectHole(indices, ngon, connection, vertex_indices, handler);
+}
 
 template<class Handler>
-inline void SelectConnected(const IArray<int>& indices, int ngon, const IArray<float3>& vertices,
+inline void SelectHole(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
+    const IArray<int>& vertex_indices, const Handler& handler)
+{
+    ConnectionData connection;
+    connection.buildConnection(indices, counts, offsets, vertices, true);
+    SelectHole(indices, counts, offsets, connection, vertex_indices, handler);
+}
+
+
+template<class Handler>
+inline void SelectConnected(const IArray<int>& indices, int ngon, const ConnectionData& connection,
     const IArray<int>& vertex_indices, const Handler& handler)
 {
     impl::CountsC counts{ ngon, indices.size() / ngon };
     impl::OffsetsC offsets{ ngon, indices.size() / ngon };
 
-    ConnectionData connection;
-    impl::BuildConnection(connection, indices, counts, vertices);
-
     impl::SelectEdgeImpl<decltype(indices), decltype(counts), decltype(offsets)>
-        impl(indices, counts, offsets, vertices, connection);
+        impl(indices, counts, offsets, connection);
 
     for (int i : vertex_indices) {
         impl.selectConnected(i, handler);
@@ -383,20 +401,35 @@ inline void SelectConnected(const IArray<int>& indices, int ngon, const IArray<f
 }
 
 template<class Handler>
-inline void SelectConnected(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
+inline void SelectConnected(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const ConnectionData& connection,
     const IArray<int>& vertex_indices, const Handler& handler)
 {
-    ConnectionData connection;
-    impl::BuildConnection(connection, indices, counts, vertices);
-
     impl::SelectEdgeImpl<decltype(indices), decltype(counts), decltype(offsets)>
-        impl(indices, counts, offsets, vertices, connection);
+        impl(indices, counts, offsets, connection);
 
     for (int i : vertex_indices) {
         impl.selectConnected(i, handler);
     }
 }
 
+template<class Handler>
+inline void SelectConnected(const IArray<int>& indices, int ngon, const IArray<float3>& vertices,
+    const IArray<int>& vertex_indices, const Handler& handler)
+{
+    ConnectionData connection;
+    connection.buildConnection(indices, ngon, vertices);
+    SelectConnected(indices, ngon, connection, vertex_indices, handler);
+}
+
+template<class Handler>
+inline void SelectConnected(const IArray<int>& indices, const IArray<int>& counts, const IArray<int>& offsets, const IArray<float3>& vertices,
+    const IArray<int>& vertex_indices, const Handler& handler)
+{
+    ConnectionData connection;
+    impl::BuildConnection(connection, indices, counts, vertices);
+    SelectConnected(indices, counts, offsets, connection, vertex_indices, handler);
+}
+
 
 // PointsIter: indexed_iterator<const float3*, int*> or indexed_iterator_s<const float3*, int*>
 template<class PointsIter>
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "muAllocator.h"
+#include "muTLS.h"
 
 void* AlignedMalloc(size_t size, size_t alignment)
 {
@@ -22,3 +23,123 @@ void AlignedFree(void *addr)
     free(addr);
 #endif
 }
+
+
+namespace {
+
+const size_t ScratchMinChunkSize = 1024 * 1024;
+// arenas larger than this are released when the outermost scope ends
+const size_t ScratchMaxRetainedSize = 64 * 1024 * 1024;
+const size_t ScratchChunkAlignment = 0x40;
+
+// bump allocator. chunks are kept and reused across scopes.
+// every allocation (including heap fallback of ScratchAllocator) has a pointer-sized header just before it:
+// null for arena memory, or the address to free for heap memory.
+class ScratchArena
+{
+public:
+    ~ScratchArena()
+    {
+        releaseChunks();
+    }
+
+    void* allocate(size_t size, size_t alignment)
+    {
+        for (;;) {
+            if (m_chunk < m_chunks.size()) {
+                auto& c = m_chunks[m_chunk];
+                size_t begin = (m_pos + sizeof(void*) + alignment - 1) & ~(alignment - 1);
+                if (begin + size <= c.size) {
+                    m_pos = begin + size;
+                    char *ret = c.data + begin;
+                    ((void**)ret)[-1] = nullptr;
+                    return ret;
+                }
+                ++m_chunk;
+                m_pos = 0;
+                continue;
+            }
+
+            size_t required = size + alignment + sizeof(void*);
+            size_t csize = std::max<size_t>(m_chunks.empty() ? ScratchMinChunkSize : m_chunks.back().size * 2, required);
+            m_chunks.push_back({ (char*)AlignedMalloc(csize, ScratchChunkAlignment), csize });
+        }
+    }
+
+    void enter() { ++m_depth; }
+
+    void leave()
+    {
+        if (--m_depth > 0) { return; }
+
+        // merge chunks into one so that next scope doesn't need to allocate
+        size_t total = 0;
+        for (auto& c : m_chunks) { total += c.size; }
+        if (m_chunks.size() > 1 || total > ScratchMaxRetainedSize) {
+            releaseChunks();
+            if (total <= ScratchMaxRetainedSize) {
+                m_chunks.push_back({ (char*)AlignedMalloc(total, ScratchChunkAlignment), total });
+            }
+        }
+        m_chunk = 0;
+        m_pos = 0;
+    }
+
+    bool active() const { return m_depth > 0; }
+
+private:
+    struct Chunk
+    {
+        char *data;
+        size_t size;
+    };
+
+    void releaseChunks()
+    {
+        for (auto& c : m_chunks) { AlignedFree(c.data); }
+        m_chunks.clear();
+    }
+
+    std::vector<Chunk> m_chunks;
+    size_t m_chunk = 0; // current chunk
+    size_t m_pos = 0;   // position in current chunk
+    int m_depth = 0;
+};
+
+tls<ScratchArena> g_scratch_arenas;
+
+} // namespace
+
+
+void* ScratchAllocator::allocate(size_t size, size_t alignment)
+{
+    auto& arena = g_scratch_arenas.local();
+    if (arena.active()) {
+        return arena.allocate(size, alignment);
+    }
+
+    char *base = (char*)AlignedMalloc(size + alignment, alignment);
+    char *ret = base + alignment;
+    ((void**)ret)[-1] = base;
+    return ret;
+}
+
+void ScratchAllocator::deallocate(void *addr)
+{
+    if (!addr) { return; }
+    if (void *base = ((void**)addr)[-1]) {
+        AlignedFree(base);
+    }
+}
+
+ScratchScope::ScratchScope()
+{
+    auto& arena = g_scratch_arenas.local();
+    arena.enter();
+    m_arena = &arena;
+}
+
+ScratchScope::~ScratchScope()
+{
+    ((ScratchArena*)m_arena)->leave();
+}
@@ -2,3 +2,36 @@
 
 void* AlignedMalloc(size_t size, size_t alignment);
 void  AlignedFree(void *addr);
+
+
+// allocation policies of RawVector
+
+struct HeapAllocator
+{
+    static void* allocate(size_t size, size_t alignment) { return AlignedMalloc(size, alignment); }
+    static void deallocate(void *addr) { AlignedFree(addr); }
+};
+
+// allocates from the thread-local scratch arena while a ScratchScope is active on the calling thread,
+// and from the heap otherwise (e.g. in worker threads of parallel loops). deallocation of arena memory is no-op.
+// memory is reclaimed all at once when the outermost ScratchScope of the thread ends.
+struct ScratchAllocator
+{
+    static void* allocate(size_t size, size_t alignment);
+    static void deallocate(void *addr);
+};
+
+// marks the lifetime of the scratch arena of the calling thread.
+// nested scopes are no-op. only the outermost one resets the arena when it ends, so containers allocated by
+// ScratchAllocator (ScratchVector) must not outlive it. put it at the beginning of the API call.
+class ScratchScope
+{
+public:
+    ScratchScope();
+    ~ScratchScope();
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+private:
+    void *m_arena;
+};
@@ -0,0 +1,476 @@
+#include "pch.h"
+#include "MeshUtils.h"
+
+namespace mu {
+
+namespace {
+
+struct AABB
+{
+    float3 bmin = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float3 bmax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    void expand(const float3& p)
+    {
+        bmin = min(bmin, p);
+        bmax = max(bmax, p);
+    }
+    void expand(const AABB& v)
+    {
+        bmin = min(bmin, v.bmin);
+        bmax = max(bmax, v.bmax);
+    }
+    float area() const
+    {
+        if (bmin.x > bmax.x) { return 0.0f; }
+        float3 e = bmax - bmin;
+        return (e.x * e.y + e.y * e.z + e.z * e.x) * 2.0f;
+    }
+};
+
+struct BuildTask
+{
+    int node;
+    int begin, end;
+    int depth;
+};
+
+struct RayKey
+{
+    uint32_t code;
+    int index;
+
+    bool operator<(const RayKey& v) const { return code < v.code || (code == v.code && index < v.index); }
+};
+
+// spread lower 9 bits of v to every 3rd bit
+inline uint32_t SpreadBits(uint32_t v)
+{
+    v &= 0x1ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+// avoid inf * 0 in slab test
+inline float SafeRcp(float v)
+{
+    const float e = 1e-30f;
+    return 1.0f / (std::abs(v) < e ? (v < 0.0f ? -e : e) : v);
+}
+
+const int NumBins = 16;
+// beyond this depth median split is used to keep the traversal stack bounded
+const int MaxSAHDepth = 40;
+const int MaxDepth = 64;
+
+} // namespace
+
+
+void TriangleBVH::clear()
+{
+    m_num_nodes = 0;
+    m_bmin_x.clear(); m_bmin_y.clear(); m_bmin_z.clear();
+    m_bmax_x.clear(); m_bmax_y.clear(); m_bmax_z.clear();
+    m_offsets.clear();
+    m_counts.clear();
+
+    m_v1x.clear(); m_v1y.clear(); m_v1z.clear();
+    m_v2x.clear(); m_v2y.clear(); m_v2z.clear();
+    m_v3x.clear(); m_v3y.clear(); m_v3z.clear();
+    m_tindices.clear();
+}
+
+void TriangleBVH::build(const float3 *vertices, const int *indices, int num_triangles)
+{
+    clear();
+    if (num_triangles <= 0) { return; }
+
+    // per-triangle bounds and centroids.
+    // bounds are slightly padded because ray_triangle_intersection() has tolerance on barycentric coordinates.
+    RawVector<AABB> tbounds;
+    RawVector<float3> centroids;
+    tbounds.resize(num_triangles);
+    centroids.resize(num_triangles);
+    parallel_for(0, num_triangles, [&](int ti) {
+        float3 p1 = vertices[indices[ti * 3 + 0]];
+        float3 p2 = vertices[indices[ti * 3 + 1]];
+        float3 p3 = vertices[indices[ti * 3 + 2]];
+        AABB b;
+        b.expand(p1); b.expand(p2); b.expand(p3);
+        float3 e = b.bmax - b.bmin;
+        float pad = std::max<float>(std::max<float>(e.x, e.y), e.z) * 1e-3f + 1e-6f;
+        b.bmin -= float3{ pad, pad, pad };
+        b.bmax += float3{ pad, pad, pad };
+        tbounds[ti] = b;
+        centroids[ti] = (p1 + p2 + p3) / 3.0f;
+    });
+
+    RawVector<int> order;
+    order.resize(num_triangles);
+    std::iota(order.begin(), order.end(), 0);
+
+    int max_nodes = num_triangles * 2;
+    m_bmin_x.resize(max_nodes); m_bmin_y.resize(max_nodes); m_bmin_z.resize(max_nodes);
+    m_bmax_x.resize(max_nodes); m_bmax_y.resize(max_nodes); m_bmax_z.resize(max_nodes);
+    m_offsets.resize(max_nodes);
+    m_counts.resize(max_nodes);
+
+    auto make_leaf = [&](int node, int begin, int end) {
+        // keep source order inside leaves so that ties are resolved same as linear search
+        std::sort(order.begin() + begin, order.begin() + end);
+        m_offsets[node] = begin;
+        m_counts[node] = end - begin;
+    };
+
+    RawVector<BuildTask> tasks;
+    tasks.push_back({ 0, 0, num_triangles, 0 });
+    m_num_nodes = 1;
+
+    while (!tasks.empty()) {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        int node = task.node;
+        int begin = task.begin;
+        int end = task.end;
+        int count = end - begin;
+
+        AABB bounds, cbounds;
+        for (int i = begin; i < end; ++i) {
+            bounds.expand(tbounds[order[i]]);
+            cbounds.expand(centroids[order[i]]);
+        }
+        m_bmin_x[node] = bounds.bmin.x; m_bmin_y[node] = bounds.bmin.y; m_bmin_z[node] = bounds.bmin.z;
+        m_bmax_x[node] = bounds.bmax.x; m_bmax_y[node] = bounds.bmax.y; m_bmax_z[node] = bounds.bmax.z;
+
+        if (count <= MaxLeafTriangles || task.depth >= MaxDepth - 2) {
+            make_leaf(node, begin, end);
+            continue;
+        }
+
+        float3 cextent = cbounds.bmax - cbounds.bmin;
+        int axis = 0;
+        if (cextent.y > cextent[axis]) { axis = 1; }
+        if (cextent.z > cextent[axis]) { axis = 2; }
+        if (cextent[axis] <= 0.0f) {
+            // all centroids are identical. nothing to split.
+            make_leaf(node, begin, end);
+            continue;
+        }
+
+        int mid = -1;
+        if (task.depth < MaxSAHDepth) {
+            // binned SAH. evaluate all axes and pick the cheapest split.
+            float best_cost = FLT_MAX;
+            int best_axis = -1;
+            int best_bin = -1;
+            for (int a = 0; a < 3; ++a) {
+                if (cextent[a] <= 0.0f) { continue; }
+
+                AABB bins[NumBins];
+                int bin_counts[NumBins] = {};
+                float cmin = cbounds.bmin[a];
+                float scale = NumBins / cextent[a];
+                for (int i = begin; i < end; ++i) {
+                    int ti = order[i];
+                    int bi = std::min<int>(int((centroids[ti][a] - cmin) * scale), NumBins - 1);
+                    bins[bi].expand(tbounds[ti]);
+                    ++bin_counts[bi];
+                }
+
+                float right_area[NumBins];
+                int right_count[NumBins];
+                {
+                    AABB b;
+                    int c = 0;
+                    for (int bi = NumBins - 1; bi > 0; --bi) {
+                        b.expand(bins[bi]);
+                        c += bin_counts[bi];
+                        right_area[bi] = b.area();
+                        right_count[bi] = c;
+                    }
+                }
+                {
+                    AABB b;
+                    int c = 0;
+                    for (int bi = 0; bi < NumBins - 1; ++bi) {
+                        b.expand(bins[bi]);
+                        c += bin_counts[bi];
+                        if (c == 0 || right_count[bi + 1] == 0) { continue; }
+                        float cost = b.area() * c + right_area[bi + 1] * right_count[bi + 1];
+                        if (cost < best_cost) {
+                            best_cost = cost;
+                            best_axis = a;
+                            best_bin = bi;
+                        }
+                    }
+                }
+            }
+
+            float leaf_cost = bounds.area() * count;
+            if (best_axis == -1 || (best_cost >= leaf_cost && count <= MaxLeafTriangles * 4)) {
+                make_leaf(node, begin, end);
+                continue;
+            }
+
+            float cmin = cbounds.bmin[best_axis];
+            float scale = NumBins / cextent[best_axis];
+            auto *pmid = std::partition(order.begin() + begin, order.begin() + end, [&](int ti) {
+                int bi = std::min<int>(int((centroids[ti][best_axis] - cmin) * scale), NumBins - 1);
+                return bi <= best_bin;
+            });
+            mid = int(pmid - order.begin());
+        }
+
+        if (mid <= begin || mid >= end) {
+            // median split
+            mid = begin + count / 2;
+            std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](int a, int b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+        }
+
+        int left = m_num_nodes;
+        m_num_nodes += 2;
+        m_offsets[node] = left;
+        m_counts[node] = 0;
+        tasks.push_back({ left + 1, mid, end, task.depth + 1 });
+        tasks.push_back({ left, begin, mid, task.depth + 1 });
+    }
+
+    // reorder triangles
+    m_tindices.swap(order);
+    m_v1x.resize(num_triangles); m_v1y.resize(num_triangles); m_v1z.resize(num_triangles);
+    m_v2x.resize(num_triangles); m_v2y.resize(num_triangles); m_v2z.resize(num_triangles);
+    m_v3x.resize(num_triangles); m_v3y.resize(num_triangles); m_v3z.resize(num_triangles);
+    parallel_for(0, num_triangles, [&](int i) {
+        int ti = m_tindices[i];
+        float3 p1 = vertices[indices[ti * 3 + 0]];
+        float3 p2 = vertices[indices[ti * 3 + 1]];
+        float3 p3 = vertices[indices[ti * 3 + 2]];
+        m_v1x[i] = p1.x; m_v1y[i] = p1.y; m_v1z[i] = p1.z;
+        m_v2x[i] = p2.x; m_v2y[i] = p2.y; m_v2z[i] = p2.z;
+        m_v3x[i] = p3.x; m_v3y[i] = p3.y; m_v3z[i] = p3.z;
+    });
+}
+
+int TriangleBVH::raycast(float3 pos, float3 dir, int& tindex, float& distance) const
+{
+    if (m_num_nodes == 0) { return 0; }
+
+    float3 idir = { SafeRcp(dir.x), SafeRcp(dir.y), SafeRcp(dir.z) };
+
+    float nearest = FLT_MAX;
+    int nearest_ti = -1;
+
+    // return entry distance of the ray, or -1 if the ray doesn't hit the node before current nearest hit
+    auto hit_node = [&](int ni) -> float {
+        float tx1 = (m_bmin_x[ni] - pos.x) * idir.x, tx2 = (m_bmax_x[ni] - pos.x) * idir.x;
+        float ty1 = (m_bmin_y[ni] - pos.y) * idir.y, ty2 = (m_bmax_y[ni] - pos.y) * idir.y;
+        float tz1 = (m_bmin_z[ni] - pos.z) * idir.z, tz2 = (m_bmax_z[ni] - pos.z) * idir.z;
+        float tmin = std::max<float>(std::max<float>(std::min<float>(tx1, tx2), std::min<float>(ty1, ty2)), std::min<float>(tz1, tz2));
+        float tmax = std::min<float>(std::min<float>(std::max<float>(tx1, tx2), std::max<float>(ty1, ty2)), std::max<float>(tz1, tz2));
+        tmin = std::max<float>(tmin, 0.0f);
+        return tmin <= tmax && tmin <= nearest ? tmin : -1.0f;
+    };
+
+    if (hit_node(0) < 0.0f) { return 0; }
+
+    int stack[MaxDepth];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        int ni = stack[--sp];
+        int count = m_counts[ni];
+        if (count > 0) {
+            int first = m_offsets[ni];
+            int ti;
+            float d;
+            int num_hits = RayTrianglesIntersectionSoA(pos, dir,
+                m_v1x.data() + first, m_v1y.data() + first, m_v1z.data() + first,
+                m_v2x.data() + first, m_v2y.data() + first, m_v2z.data() + first,
+                m_v3x.data() + first, m_v3y.data() + first, m_v3z.data() + first,
+                count, ti, d);
+            if (num_hits > 0) {
+                int sti = m_tindices[first + ti];
+                if (d < nearest || (d == nearest && (nearest_ti == -1 || sti < nearest_ti))) {
+                    nearest = d;
+                    nearest_ti = sti;
+                }
+            }
+            continue;
+        }
+
+        int left = m_offsets[ni];
+        int right = left + 1;
+        float dl = hit_node(left);
+        float dr = hit_node(right);
+        if (dl >= 0.0f && dr >= 0.0f) {
+            // visit nearer child first
+            if (dl <= dr) {
+                stack[sp++] = right;
+                stack[sp++] = left;
+            }
+            else {
+                stack[sp++] = left;
+                stack[sp++] = right;
+            }
+        }
+        else if (dl >= 0.0f) {
+            stack[sp++] = left;
+        }
+        else if (dr >= 0.0f) {
+            stack[sp++] = right;
+        }
+    }
+
+    if (nearest_ti != -1) {
+        tindex = nearest_ti;
+        distance = nearest;
+        return 1;
+    }
+    return 0;
+}
+
+const int TriangleBVH::RayPacketSize;
+
+void TriangleBVH::raycast(int num_rays, const float3 *pos, const float3 *dir, float max_distance,
+    int *dst_tindices, float *dst_distances) const
+{
+    if (num_rays <= 0) { return; }
+    if (m_num_nodes == 0) {
+        std::fill(dst_tindices, dst_tindices + num_rays, -1);
+        std::fill(dst_distances, dst_distances + num_rays, FLT_MAX);
+        return;
+    }
+
+    // sort rays by octant of directions and then Morton code of origins
+    RawVector<RayKey> keys;
+    keys.resize(num_rays);
+    {
+        AABB bounds;
+        for (int ri = 0; ri < num_rays; ++ri) {
+            bounds.expand(pos[ri]);
+        }
+        float3 extent = bounds.bmax - bounds.bmin;
+        float3 scale = {
+            extent.x > 0.0f ? 511.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 511.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 511.0f / extent.z : 0.0f,
+        };
+        parallel_for(0, num_rays, [&](int ri) {
+            float3 q = (pos[ri] - bounds.bmin) * scale;
+            float3 d = dir[ri];
+            uint32_t octant = (d.x < 0.0f ? 1 : 0) | (d.y < 0.0f ? 2 : 0) | (d.z < 0.0f ? 4 : 0);
+            uint32_t code = SpreadBits((uint32_t)q.x) | (SpreadBits((uint32_t)q.y) << 1) | (SpreadBits((uint32_t)q.z) << 2);
+            keys[ri] = { (octant << 27) | code, ri };
+        });
+        std::sort(keys.begin(), keys.end());
+    }
+
+    int num_packets = ceildiv(num_rays, RayPacketSize);
+    parallel_for(0, num_packets, [&](int pi) {
+        int base = pi * RayPacketSize;
+        int n = std::min<int>(num_rays - base, RayPacketSize);
+
+        int rindices[RayPacketSize];
+        float3 rpos[RayPacketSize], rdir[RayPacketSize], ridir[RayPacketSize];
+        float nearest[RayPacketSize];
+        int nearest_ti[RayPacketSize];
+        for (int k = 0; k < n; ++k) {
+            int ri = keys[base + k].index;
+            rindices[k] = ri;
+            rpos[k] = pos[ri];
+            rdir[k] = dir[ri];
+            ridir[k] = { SafeRcp(rdir[k].x), SafeRcp(rdir[k].y), SafeRcp(rdir[k].z) };
+            nearest[k] = max_distance;
+            nearest_ti[k] = -1;
+        }
+
+        // same as raycast()
+        auto hit_node = [&](int ni, int k) -> float {
+            const float3& p = rpos[k];
+            const float3& idir = ridir[k];
+            float tx1 = (m_bmin_x[ni] - p.x) * idir.x, tx2 = (m_bmax_x[ni] - p.x) * idir.x;
+            float ty1 = (m_bmin_y[ni] - p.y) * idir.y, ty2 = (m_bmax_y[ni] - p.y) * idir.y;
+            float tz1 = (m_bmin_z[ni] - p.z) * idir.z, tz2 = (m_bmax_z[ni] - p.z) * idir.z;
+            float tmin = std::max<float>(std::max<float>(std::min<float>(tx1, tx2), std::min<float>(ty1, ty2)), std::min<float>(tz1, tz2));
+            float tmax = std::min<float>(std::min<float>(std::max<float>(tx1, tx2), std::max<float>(ty1, ty2)), std::max<float>(tz1, tz2));
+            tmin = std::max<float>(tmin, 0.0f);
+            return tmin <= tmax && tmin <= nearest[k] ? tmin : -1.0f;
+        };
+        // nearest entry distance of rays in the packet, or -1 if none of them hit the node
+        auto hit_node_packet = [&](int ni) -> float {
+            float ret = -1.0f;
+            for (int k = 0; k < n; ++k) {
+                float d = hit_node(ni, k);
+                if (d >= 0.0f && (ret < 0.0f || d < ret)) { ret = d; }
+            }
+            return ret;
+        };
+
+        if (hit_node_packet(0) >= 0.0f) {
+            int stack[MaxDepth];
+            int sp = 0;
+            stack[sp++] = 0;
+            while (sp > 0) {
+                int ni = stack[--sp];
+                int count = m_counts[ni];
+                if (count > 0) {
+                    int first = m_offsets[ni];
+                    for (int k = 0; k < n; ++k) {
+                        if (hit_node(ni, k) < 0.0f) { continue; }
+                        int ti;
+                        float d;
+                        int num_hits = RayTrianglesIntersectionSoA(rpos[k], rdir[k],
+                            m_v1x.data() + first, m_v1y.data() + first, m_v1z.data() + first,
+                            m_v2x.data() + first, m_v2y.data() + first, m_v2z.data() + first,
+                            m_v3x.data() + first, m_v3y.data() + first, m_v3z.data() + first,
+                            count, ti, d);
+                        if (num_hits > 0) {
+                            int sti = m_tindices[first + ti];
+                            // inclusive as the single ray version. a hit at exactly max_distance is accepted.
+                            if (d < nearest[k] || (d == nearest[k] && (nearest_ti[k] == -1 || sti < nearest_ti[k]))) {
+                                nearest[k] = d;
+                                nearest_ti[k] = sti;
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                int left = m_offsets[ni];
+                int right = left + 1;
+                float dl = hit_node_packet(left);
+                float dr = hit_node_packet(right);
+                if (dl >= 0.0f && dr >= 0.0f) {
+                    if (dl <= dr) {
+                        stack[sp++] = right;
+                        stack[sp++] = left;
+                    }
+                    else {
+                        stack[sp++] = left;
+                        stack[sp++] = right;
+                    }
+                }
+                else if (dl >= 0.0f) {
+                    stack[sp++] = left;
+                }
+                else if (dr >= 0.0f) {
+                    stack[sp++] = right;
+                }
+            }
+        }
+
+        for (int k = 0; k < n; ++k) {
+            int ri = rindices[k];
+            dst_tindices[ri] = nearest_ti[k];
+            dst_distances[ri] = nearest_ti[k] != -1 ? nearest[k] : FLT_MAX;
+        }
+    });
+}
+
+} // namespace mu
@@ -0,0 +1,52 @@
+#pragma once
+
+namespace mu {
+
+// bounding volume hierarchy of indexed triangles for ray queries.
+// built by binned SAH. node bounds are stored as SoA and leaves refer contiguous ranges of
+// reordered triangles (also SoA) so that RayTrianglesIntersectionSoA() can be used for leaves.
+class TriangleBVH
+{
+public:
+    static const int MaxLeafTriangles = 8;
+
+    void clear();
+    void build(const float3 *vertices, const int *indices, int num_triangles);
+
+    bool empty() const { return m_num_nodes == 0; }
+    int getNumTriangles() const { return (int)m_tindices.size(); }
+    int getNumNodes() const { return m_num_nodes; }
+
+    // find nearest intersection. return 1 if hit, 0 otherwise.
+    // tindex is the index of the triangle in the source indices (not reordered one).
+    int raycast(float3 pos, float3 dir, int& tindex, float& distance) const;
+
+    // batched version of raycast(). rays are sorted by Morton code of origins (and octant of directions) and
+    // traversed in packets of RayPacketSize so that coherent rays share node visits.
+    // hits farther than max_distance are culled. rays don't need to be normalized (distances are parametric).
+    // dst_tindices receive -1 and dst_distances receive FLT_MAX for rays that don't hit.
+    // fixed on purpose: packets are traversed by scalar code with arrays sized at compile time,
+    // so it doesn't follow GetSIMDWidth().
+    static const int RayPacketSize = 8;
+    void raycast(int num_rays, const float3 *pos, const float3 *dir, float max_distance,
+        int *dst_tindices, float *dst_distances) const;
+
+private:
+    int m_num_nodes = 0;
+
+    // node bounds
+    RawVector<float> m_bmin_x, m_bmin_y, m_bmin_z;
+    RawVector<float> m_bmax_x, m_bmax_y, m_bmax_z;
+    // internal node: index of left child (right child is next to it). leaf node: index of first triangle
+    RawVector<int> m_offsets;
+    // internal node: 0. leaf node: number of triangles
+    RawVector<int> m_counts;
+
+    // reordered triangles
+    RawVector<float> m_v1x, m_v1y, m_v1z;
+    RawVector<float> m_v2x, m_v2y, m_v2z;
+    RawVector<float> m_v3x, m_v3y, m_v3z;
+    RawVector<int> m_tindices; // reordered index -> source triangle index
+};
+
+} // namespace mu
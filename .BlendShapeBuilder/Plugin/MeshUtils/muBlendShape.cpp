@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "MeshUtils.h"
+
+namespace mu {
+
+// vertices are tested by SIMD per blocks first. most blocks of usual blend shapes don't move at all.
+static const int SparseDeltaBlockSize = 64;
+
+void SparseDelta::clear()
+{
+    num_vertices = 0;
+    indices.clear();
+    points.clear();
+    normals.clear();
+    tangents.clear();
+}
+
+void SparseDelta::fromDense(const float3 *src_points, const float3 *src_normals, const float3 *src_tangents, int num_vertices_, float eps)
+{
+    clear();
+    num_vertices = num_vertices_;
+    if (num_vertices <= 0) { return; }
+
+    auto moved = [&](const float3 *src, int vi, int n) {
+        return src && !NearZero(src + vi, n, eps);
+    };
+    auto moved_any = [&](int vi, int n) {
+        return moved(src_points, vi, n) || moved(src_normals, vi, n) || moved(src_tangents, vi, n);
+    };
+
+    int num_blocks = ceildiv(num_vertices, SparseDeltaBlockSize);
+    RawVector<int> counts, offsets;
+    counts.resize(num_blocks);
+    offsets.resize(num_blocks);
+    parallel_for(0, num_blocks, [&](int bi) {
+        int vi = bi * SparseDeltaBlockSize;
+        int vend = std::min<int>(vi + SparseDeltaBlockSize, num_vertices);
+        int c = 0;
+        if (moved_any(vi, vend - vi)) {
+            for (; vi < vend; ++vi) {
+                if (moved_any(vi, 1)) { ++c; }
+            }
+        }
+        counts[bi] = c;
+    });
+
+    int total = 0;
+    for (int bi = 0; bi < num_blocks; ++bi) {
+        offsets[bi] = total;
+        total += counts[bi];
+    }
+
+    indices.resize_discard(total);
+    if (src_points) { points.resize_discard(total); }
+    if (src_normals) { normals.resize_discard(total); }
+    if (src_tangents) { tangents.resize_discard(total); }
+    parallel_for(0, num_blocks, [&](int bi) {
+        if (counts[bi] == 0) { return; }
+        int vi = bi * SparseDeltaBlockSize;
+        int vend = std::min<int>(vi + SparseDeltaBlockSize, num_vertices);
+        int i = offsets[bi];
+        for (; vi < vend; ++vi) {
+            if (!moved_any(vi, 1)) { continue; }
+            indices[i] = vi;
+            if (src_points) { points[i] = src_points[vi]; }
+            if (src_normals) { normals[i] = src_normals[vi]; }
+            if (src_tangents) { tangents[i] = src_tangents[vi]; }
+            ++i;
+        }
+    });
+}
+
+void SparseDelta::toDense(float3 *dst_points, float3 *dst_normals, float3 *dst_tangents) const
+{
+    auto scatter = [&](float3 *dst, const RawVector<float3>& src) {
+        if (!dst) { return; }
+        memset(dst, 0, sizeof(float3) * num_vertices);
+        if (src.empty()) { return; }
+        int n = size();
+        for (int i = 0; i < n; ++i) {
+            dst[indices[i]] = src[i];
+        }
+    };
+    scatter(dst_points, points);
+    scatter(dst_normals, normals);
+    scatter(dst_tangents, tangents);
+}
+
+void SparseDelta::getRange(int vbegin, int vend, int& first, int& last) const
+{
+    first = int(std::lower_bound(indices.begin(), indices.end(), vbegin) - indices.begin());
+    last = int(std::lower_bound(indices.begin() + first, indices.end(), vend) - indices.begin());
+}
+
+
+void SparseBlendShape::clear()
+{
+    frames.clear();
+}
+
+SparseDelta& SparseBlendShape::addFrame(float weight)
+{
+    auto it = std::upper_bound(frames.begin(), frames.end(), weight,
+        [](float w, const Frame& f) { return w < f.weight; });
+    it = frames.insert(it, Frame());
+    it->weight = weight;
+    return it->delta;
+}
+
+
+void EvaluateBlendShapes(
+    float3 *dst_points, float3 *dst_normals, float4 *dst_tangents,
+    const float3 *base_points, const float3 *base_normals, const float4 *base_tangents, int num_vertices,
+    const SparseBlendShape * const *shapes, const float *weights, int num_shapes)
+{
+    if (num_vertices <= 0) { return; }
+
+    // gather active frames first
+    struct FrameWeight
+    {
+        const SparseDelta *delta;
+        float coef;
+    };
+    RawVector<FrameWeight> active;
+    for (int si = 0; si < num_shapes; ++si) {
+        if (!shapes[si]) { continue; }
+        shapes[si]->eachFrames(weights[si], [&](const SparseDelta& delta, float coef) {
+            if (!delta.empty() && delta.num_vertices == num_vertices) {
+                active.push_back({ &delta, coef });
+            }
+        });
+    }
+
+    parallel_for_blocked(0, num_vertices, 4096, [&](int vbegin, int vend) {
+        int n = vend - vbegin;
+        if (dst_points && base_points)
+            memcpy(dst_points + vbegin, base_points + vbegin, sizeof(float3) * n);
+        if (dst_normals && base_normals)
+            memcpy(dst_normals + vbegin, base_normals + vbegin, sizeof(float3) * n);
+        if (dst_tangents && base_tangents)
+            memcpy(dst_tangents + vbegin, base_tangents + vbegin, sizeof(float4) * n);
+
+        for (auto& a : active) {
+            auto& d = *a.delta;
+            int first, last;
+            d.getRange(vbegin, vend, first, last);
+            int count = last - first;
+            if (count == 0) { continue; }
+            if (dst_points && !d.points.empty())
+                MulAddIndexed(dst_points, d.points.cdata() + first, d.indices.cdata() + first, a.coef, count);
+            if (dst_normals && !d.normals.empty())
+                MulAddIndexed(dst_normals, d.normals.cdata() + first, d.indices.cdata() + first, a.coef, count);
+            if (dst_tangents && !d.tangents.empty())
+                MulAddIndexed(dst_tangents, d.tangents.cdata() + first, d.indices.cdata() + first, a.coef, count);
+        }
+
+        if (dst_normals && !active.empty()) {
+            Normalize(dst_normals + vbegin, n);
+        }
+    });
+}
+
+} // namespace mu
@@ -0,0 +1,83 @@
+#pragma once
+
+namespace mu {
+
+// blend shape frame that stores deltas of moved vertices only.
+// normals and tangents are optional and empty if the dense form didn't have them.
+struct SparseDelta
+{
+    int num_vertices = 0; // number of vertices of the dense form
+    RawVector<int> indices;
+    RawVector<float3> points;
+    RawVector<float3> normals;
+    RawVector<float3> tangents;
+
+    void clear();
+    int size() const { return (int)indices.size(); }
+    bool empty() const { return indices.empty(); }
+
+    // vertices whose delta of all channels are near zero are eliminated. null channels are ignored.
+    void fromDense(const float3 *points, const float3 *normals, const float3 *tangents, int num_vertices, float eps = muEpsilon);
+    // dst_* must have num_vertices elements. they are zero cleared and then deltas are scattered.
+    // null destinations are ignored.
+    void toDense(float3 *dst_points, float3 *dst_normals, float3 *dst_tangents) const;
+    // range of elements that refer vertices in [vbegin, vend).
+    void getRange(int vbegin, int vend, int& first, int& last) const;
+};
+
+// blend shape with in-between frames. Unity compatible: weight is compared with weights of frames
+// (usually 100 for the last one) and the delta is interpolated between the adjacent frames.
+struct SparseBlendShape
+{
+    struct Frame
+    {
+        float weight = 0.0f;
+        SparseDelta delta;
+    };
+    std::vector<Frame> frames; // sorted by weight
+
+    void clear();
+    // frames are kept sorted. returned reference is valid until next addFrame().
+    SparseDelta& addFrame(float weight);
+
+    // Body: [](const SparseDelta& delta, float coef) -> void
+    // frames and their coefficients that compose the shape at weight.
+    template<class Body>
+    void eachFrames(float weight, const Body& body) const;
+};
+
+// dst = base + sum of shapes[i] at weights[i]. shapes with zero weight are skipped.
+// null dst channels are skipped. if a base channel is null, dst is accumulated onto its current content.
+// normals are re-normalized and w of tangents is kept.
+void EvaluateBlendShapes(
+    float3 *dst_points, float3 *dst_normals, float4 *dst_tangents,
+    const float3 *base_points, const float3 *base_normals, const float4 *base_tangents, int num_vertices,
+    const SparseBlendShape * const *shapes, const float *weights, int num_shapes);
+
+
+template<class Body>
+inline void SparseBlendShape::eachFrames(float weight, const Body& body) const
+{
+    int num_frames = (int)frames.size();
+    if (num_frames == 0 || weight == 0.0f) { return; }
+
+    // first frame is interpolated from zero. beyond the last frame the adjacent frames are extrapolated.
+    int i = 0;
+    while (i < num_frames - 1 && frames[i].weight < weight) { ++i; }
+    if (i == 0) {
+        auto& f = frames[0];
+        if (f.weight != 0.0f) {
+            body(f.delta, weight / f.weight);
+        }
+        return;
+    }
+
+    auto& f1 = frames[i - 1];
+    auto& f2 = frames[i];
+    float range = f2.weight - f1.weight;
+    float t = range > 0.0f ? (weight - f1.weight) / range : 1.0f;
+    if (t != 1.0f) { body(f1.delta, 1.0f - t); }
+    if (t != 0.0f) { body(f2.delta, t); }
+}
+
+} // namespace mu
@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "MeshUtils.h"
+
+namespace mu {
+
+// encode / decode by blocks in parallel. each block is processed by SIMD.
+static const int CompressionBlockSize = 1024;
+
+void CompressedVertices::clear()
+{
+    num_vertices = 0;
+    tangent_size = 0;
+    bmin = bmax = float3::zero();
+    points.clear();
+    normals.clear();
+    tangents.clear();
+}
+
+size_t CompressedVertices::getMemorySize() const
+{
+    return sizeof(uint16_t) * (points.size() + normals.size() + tangents.size());
+}
+
+void CompressedVertices::encodePN(const float3 *src_points, const float3 *src_normals, int num_vertices_)
+{
+    clear();
+    num_vertices = std::max<int>(num_vertices_, 0);
+    if (num_vertices == 0) { return; }
+
+    if (src_points) {
+        MinMax(src_points, num_vertices, bmin, bmax);
+        points.resize_discard(num_vertices * 3);
+        parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+            QuantizePoints(points.data() + vi * 3, src_points + vi, vend - vi, bmin, bmax);
+        });
+    }
+    if (src_normals) {
+        normals.resize_discard(num_vertices * 3);
+        parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+            FloatToHalfBits(normals.data() + vi * 3, (const float*)(src_normals + vi), (vend - vi) * 3);
+        });
+    }
+}
+
+void CompressedVertices::encode(const float3 *src_points, const float3 *src_normals, const float4 *src_tangents, int num_vertices_)
+{
+    encodePN(src_points, src_normals, num_vertices_);
+    if (src_tangents && num_vertices > 0) {
+        tangent_size = 4;
+        tangents.resize_discard(num_vertices * 4);
+        parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+            FloatToHalfBits(tangents.data() + vi * 4, (const float*)(src_tangents + vi), (vend - vi) * 4);
+        });
+    }
+}
+
+void CompressedVertices::encode(const float3 *src_points, const float3 *src_normals, const float3 *src_tangents, int num_vertices_)
+{
+    encodePN(src_points, src_normals, num_vertices_);
+    if (src_tangents && num_vertices > 0) {
+        tangent_size = 3;
+        tangents.resize_discard(num_vertices * 3);
+        parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+            FloatToHalfBits(tangents.data() + vi * 3, (const float*)(src_tangents + vi), (vend - vi) * 3);
+        });
+    }
+}
+
+void CompressedVertices::decodePN(float3 *dst_points, float3 *dst_normals) const
+{
+    if (dst_points && !points.empty()) {
+        parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+            DequantizePoints(dst_points + vi, points.cdata() + vi * 3, vend - vi, bmin, bmax);
+        });
+    }
+    if (dst_normals && !normals.empty()) {
+        parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+            HalfBitsToFloat((float*)(dst_normals + vi), normals.cdata() + vi * 3, (vend - vi) * 3);
+        });
+    }
+}
+
+// Dst: float3 or float4. converts tangents of different size via a temporary buffer per block.
+template<class Dst>
+static void DecodeTangents(Dst *dst, const RawVector<uint16_t>& src, int tangent_size, int num_vertices)
+{
+    const int dst_size = sizeof(Dst) / sizeof(float);
+    parallel_for_blocked(0, num_vertices, CompressionBlockSize, [&](int vi, int vend) {
+        int n = vend - vi;
+        if (tangent_size == dst_size) {
+            HalfBitsToFloat((float*)(dst + vi), src.cdata() + vi * dst_size, n * dst_size);
+            return;
+        }
+        // parallel_for_blocked() may give larger range than the block size (if no threading is enabled)
+        const int TmpSize = 256;
+        float tmp[TmpSize * 4];
+        for (int ti = 0; ti < n; ti += TmpSize) {
+            int tn = std::min<int>(n - ti, TmpSize);
+            HalfBitsToFloat(tmp, src.cdata() + (vi + ti) * tangent_size, tn * tangent_size);
+            for (int i = 0; i < tn; ++i) {
+                float *d = (float*)(dst + vi + ti + i);
+                const float *s = tmp + i * tangent_size;
+                d[0] = s[0]; d[1] = s[1]; d[2] = s[2];
+                if (dst_size == 4) { d[3] = 0.0f; }
+            }
+        }
+    });
+}
+
+void CompressedVertices::decode(float3 *dst_points, float3 *dst_normals, float4 *dst_tangents) const
+{
+    decodePN(dst_points, dst_normals);
+    if (dst_tangents && !tangents.empty()) {
+        DecodeTangents(dst_tangents, tangents, tangent_size, num_vertices);
+    }
+}
+
+void CompressedVertices::decode(float3 *dst_points, float3 *dst_normals, float3 *dst_tangents) const
+{
+    decodePN(dst_points, dst_normals);
+    if (dst_tangents && !tangents.empty()) {
+        DecodeTangents(dst_tangents, tangents, tangent_size, num_vertices);
+    }
+}
+
+} // namespace mu
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace mu {
+
+// compressed copy of vertex attributes (e.g. snapshots for undo history, libraries of shapes).
+// points are quantized into 16 bit per component within their bounding box, and normals and tangents are stored as half.
+// PNT takes 20 bytes per vertex instead of 40. error of points is about (bmax - bmin) / 131070 per component at most.
+// tangents can be float4 (usual tangents) or float3 (e.g. deltas of tangents).
+struct CompressedVertices
+{
+    int num_vertices = 0;
+    int tangent_size = 0; // 3 or 4. 0 if tangents are omitted
+    float3 bmin = float3::zero();
+    float3 bmax = float3::zero();
+    RawVector<uint16_t> points;   // num_vertices * 3
+    RawVector<uint16_t> normals;  // num_vertices * 3
+    RawVector<uint16_t> tangents; // num_vertices * tangent_size
+
+    void clear();
+    bool empty() const { return num_vertices == 0; }
+    // bytes of compressed data
+    size_t getMemorySize() const;
+
+    // null channels are omitted
+    void encode(const float3 *points, const float3 *normals, const float4 *tangents, int num_vertices);
+    void encode(const float3 *points, const float3 *normals, const float3 *tangents, int num_vertices);
+    // dst_* must have num_vertices elements. null destinations and omitted channels are ignored.
+    // w of float4 tangents is 0 if they were float3.
+    void decode(float3 *dst_points, float3 *dst_normals, float4 *dst_tangents) const;
+    void decode(float3 *dst_points, float3 *dst_normals, float3 *dst_tangents) const;
+
+private:
+    void encodePN(const float3 *points, const float3 *normals, int num_vertices);
+    void decodePN(float3 *dst_points, float3 *dst_normals) const;
+};
+
+} // namespace mu
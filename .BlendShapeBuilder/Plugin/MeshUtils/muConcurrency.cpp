@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "MeshUtils.h"
+
+#ifdef muEnableStdThreads
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+
+namespace mu {
+
+namespace {
+
+using Task = std::function<void()>;
+
+class ThreadPool
+{
+public:
+    static ThreadPool& getInstance();
+
+    ThreadPool();
+    ~ThreadPool();
+    int getConcurrency() const { return (int)m_workers.size() + 1; }
+
+    void enqueue(const Task& task);
+    // process one queued task on the calling thread. returns false if there was none.
+    bool runOneTask();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerMain(int wi);
+    bool pop(int qi, Task& task); // from back (own queue)
+    bool steal(int qi, Task& task); // from front (other's queue)
+    bool tryGetTask(int qi, Task& task);
+
+    std::vector<std::thread> m_workers;
+    // m_queues[0] is shared by non-worker threads. m_queues[1 + i] is owned by worker i.
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::atomic_int m_num_pending{ 0 };
+    std::atomic_int m_next_queue{ 0 };
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    static thread_local int s_queue_index;
+};
+
+thread_local int ThreadPool::s_queue_index = 0;
+
+ThreadPool& ThreadPool::getInstance()
+{
+    static ThreadPool s_instance;
+    return s_instance;
+}
+
+ThreadPool::ThreadPool()
+{
+    int num_workers = std::max<int>((int)std::thread::hardware_concurrency() - 1, 0);
+    for (int i = 0; i < num_workers + 1; ++i) {
+        m_queues.emplace_back(new Queue());
+    }
+    for (int i = 0; i < num_workers; ++i) {
+        m_workers.emplace_back([this, i]() { workerMain(i + 1); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto& t : m_workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::enqueue(const Task& task)
+{
+    // workers push to their own queues so that nested tasks stay local.
+    // other threads distribute tasks across queues.
+    int qi = s_queue_index;
+    if (qi == 0) {
+        qi = m_next_queue++ % (int)m_queues.size();
+        if (qi < 0) { qi += (int)m_queues.size(); }
+    }
+    {
+        // lock to avoid the race with workers that are about to sleep
+        std::unique_lock<std::mutex> lock(m_mutex);
+        ++m_num_pending;
+    }
+    {
+        auto& q = *m_queues[qi];
+        std::unique_lock<std::mutex> lock(q.mutex);
+        q.tasks.push_back(task);
+    }
+    m_cond.notify_one();
+}
+
+bool ThreadPool::pop(int qi, Task& task)
+{
+    auto& q = *m_queues[qi];
+    std::unique_lock<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) { return false; }
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int qi, Task& task)
+{
+    auto& q = *m_queues[qi];
+    std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+    if (!lock.owns_lock() || q.tasks.empty()) { return false; }
+    task = std::move(q.tasks.front());
+    q.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::tryGetTask(int qi, Task& task)
+{
+    if (m_num_pending == 0) { return false; }
+
+    int num_queues = (int)m_queues.size();
+    bool ret = pop(qi, task);
+    for (int i = 1; !ret && i < num_queues; ++i) {
+        ret = steal((qi + i) % num_queues, task);
+    }
+    if (!ret) {
+        // steal() gives up on contended queues. make sure nothing is left behind.
+        for (int i = 0; !ret && i < num_queues; ++i) {
+            ret = pop((qi + i) % num_queues, task);
+        }
+    }
+    if (ret) { --m_num_pending; }
+    return ret;
+}
+
+bool ThreadPool::runOneTask()
+{
+    Task task;
+    if (!tryGetTask(s_queue_index, task)) { return false; }
+    task();
+    return true;
+}
+
+void ThreadPool::workerMain(int qi)
+{
+    s_queue_index = qi;
+    Task task;
+    for (;;) {
+        if (tryGetTask(qi, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]() { return m_stop || m_num_pending > 0; });
+        if (m_stop) { break; }
+    }
+}
+
+} // namespace
+
+
+void TaskGroup::run(const std::function<void()>& task)
+{
+    ++m_num_active;
+    ThreadPool::getInstance().enqueue([this, task]() {
+        // the task is counted as finished even if it throws. the exception is passed to wait().
+        try {
+            task();
+        }
+        catch (...) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_exception) { m_exception = std::current_exception(); }
+        }
+        // notify while locked: the group can be destroyed by the waiter as soon as the lock is released
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (--m_num_active == 0) { m_cond.notify_all(); }
+    });
+}
+
+void TaskGroup::join()
+{
+    // process queued tasks (not necessarily ours) while waiting. this keeps nested loops progressing
+    // even when all workers are waiting for their own groups.
+    // when there is nothing to process, spin a little and then sleep until the tasks finish. the sleep
+    // has a timeout to pick up tasks that are queued later by the running ones.
+    auto& pool = ThreadPool::getInstance();
+    const int max_spins = 64;
+    int spins = 0;
+    while (m_num_active > 0) {
+        if (pool.runOneTask()) {
+            spins = 0;
+        }
+        else if (spins < max_spins) {
+            ++spins;
+            std::this_thread::yield();
+        }
+        else {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait_for(lock, std::chrono::milliseconds(1), [this]() { return m_num_active == 0; });
+        }
+    }
+    // a task may still be inside its final critical section
+    std::unique_lock<std::mutex> lock(m_mutex);
+}
+
+void TaskGroup::wait()
+{
+    join();
+    std::exception_ptr e;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        std::swap(e, m_exception);
+    }
+    if (e) { std::rethrow_exception(e); }
+}
+
+int GetConcurrency()
+{
+    return ThreadPool::getInstance().getConcurrency();
+}
+
+} // namespace mu
+#endif // muEnableStdThreads
@@ -5,10 +5,45 @@
     #include <ppl.h>
 #elif defined(muEnableTBB)
     #include <tbb/tbb.h>
+#elif defined(muEnableStdThreads)
+    #include <functional>
+    #include <atomic>
+    #include <mutex>
+    #include <condition_variable>
+    #include <exception>
 #endif
 
 namespace mu {
 
+#ifdef muEnableStdThreads
+// built-in backend for platforms without PPL or TBB.
+// tasks are processed by a work-stealing thread pool: each worker pops tasks from its own queue and
+// steals from others when it is empty. threads waiting for a TaskGroup process queued tasks meanwhile,
+// so nested parallel loops don't deadlock.
+class TaskGroup
+{
+public:
+    TaskGroup() {}
+    ~TaskGroup() { join(); }
+    void run(const std::function<void()>& task);
+    // rethrows the first exception thrown by the tasks, if any.
+    void wait();
+
+private:
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    void join();
+
+    std::atomic_int m_num_active{ 0 };
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::exception_ptr m_exception;
+};
+
+// number of threads that process tasks (workers + calling thread)
+int GetConcurrency();
+#endif
+
 template<class Index, class Body>
 inline void parallel_for(Index begin, Index end, const Body& body)
 {
@@ -16,21 +51,42 @@ inline void parallel_for(Index begin, Index end, const Body& body)
     concurrency::parallel_for(begin, end, body);
 #elif defined(muEnableTBB)
     tbb::parallel_for(begin, end, body);
+#elif defined(muEnableStdThreads)
+    Index num = end - begin;
+    int concurrency = GetConcurrency();
+    if (num <= 1 || concurrency <= 1) {
+        for (; begin != end; ++begin) { body(begin); }
+        return;
+    }
+
+    // a few chunks per thread to balance load. the calling thread processes the first chunk.
+    Index num_chunks = std::min<Index>(num, Index(concurrency * 4));
+    auto run_chunk = [&](Index ci) {
+        Index cbegin = begin + num * ci / num_chunks;
+        Index cend = begin + num * (ci + 1) / num_chunks;
+        for (Index i = cbegin; i != cend; ++i) { body(i); }
+    };
+    TaskGroup group;
+    for (Index ci = 1; ci < num_chunks; ++ci) {
+        group.run([&run_chunk, ci]() { run_chunk(ci); });
+    }
+    run_chunk(0);
+    group.wait();
 #else
     for (; begin != end; ++begin) { body(begin); }
 #endif
 }
 
-#if defined(muEnablePPL) || defined(muEnableTBB)
+#if defined(muEnablePPL) || defined(muEnableTBB) || defined(muEnableStdThreads)
 template<class Body>
 inline void parallel_for_blocked(int begin, int end, int granularity, const Body& body)
 {
     int num_elements = end - begin;
     int num_blocks = ceildiv(num_elements, granularity);
     parallel_for(0, num_blocks, [&](int i) {
-        int begin = granularity * i;
-        int end = std::min<int>(granularity * (i + 1), num_elements);
-        body(begin, end);
+        int b = begin + granularity * i;
+        int e = begin + std::min<int>(granularity * (i + 1), num_elements);
+        body(b, e);
     });
 }
 #else
@@ -48,11 +104,59 @@ inline void parallel_for_each(Iter begin, Iter end, const Body& body)
     concurrency::parallel_for_each(begin, end, body);
 #elif defined(muEnableTBB)
     tbb::parallel_for_each(begin, end, body);
+#elif defined(muEnableStdThreads)
+    std::vector<Iter> items;
+    for (; begin != end; ++begin) { items.push_back(begin); }
+    parallel_for(0, (int)items.size(), [&](int i) { body(*items[i]); });
 #else
     for (; begin != end; ++begin) { body(*begin); }
 #endif
 }
 
+// Body: [](int begin, int end, T partial) -> T (accumulates elements in [begin, end) into partial)
+// Join: [](const T& a, const T& b) -> T
+// identity must not change results when joined. order of joins is unspecified on PPL and TBB,
+// so Join should be commutative to make results deterministic.
+#if defined(muEnablePPL) || defined(muEnableTBB) || defined(muEnableStdThreads)
+template<class T, class Body, class Join>
+inline T parallel_reduce(int begin, int end, int granularity, const T& identity, const Body& body, const Join& join)
+{
+    if (end <= begin) { return identity; }
+#if defined(muEnablePPL)
+    concurrency::combinable<T> partials([&]() { return identity; });
+    parallel_for_blocked(begin, end, granularity, [&](int b, int e) {
+        auto& partial = partials.local();
+        partial = body(b, e, partial);
+    });
+    return partials.combine(join);
+#elif defined(muEnableTBB)
+    return tbb::parallel_reduce(tbb::blocked_range<int>(begin, end, granularity), identity,
+        [&](const tbb::blocked_range<int>& r, T partial) { return body(r.begin(), r.end(), partial); },
+        join);
+#elif defined(muEnableStdThreads)
+    // a partial per block. joined in order.
+    int num_blocks = ceildiv(end - begin, granularity);
+    std::vector<T> partials(num_blocks, identity);
+    parallel_for_blocked(begin, end, granularity, [&](int b, int e) {
+        int bi = (b - begin) / granularity;
+        partials[bi] = body(b, e, partials[bi]);
+    });
+    T ret = partials[0];
+    for (int bi = 1; bi < num_blocks; ++bi) {
+        ret = join(ret, partials[bi]);
+    }
+    return ret;
+#endif
+}
+#else
+template<class T, class Body, class Join>
+inline T parallel_reduce(int begin, int end, int /*granularity*/, const T& identity, const Body& body, const Join& /*join*/)
+{
+    if (end <= begin) { return identity; }
+    return body(begin, end, identity);
+}
+#endif
+
 
 #if defined(muEnablePPL)
 
@@ -64,6 +168,17 @@ inline void parallel_invoke(Bodies... bodies) { concurrency::parallel_invoke(bod
 template <class... Bodies>
 inline void parallel_invoke(Bodies... bodies) { tbb::parallel_invoke(bodies...); }
 
+#elif defined(muEnableStdThreads)
+
+template <class... Bodies>
+inline void parallel_invoke(Bodies... bodies)
+{
+    TaskGroup group;
+    int dummy[] = { (group.run(bodies), 0)... };
+    (void)dummy;
+    group.wait();
+}
+
 #else
 
 template <class Body>
@@ -3,9 +3,11 @@
 // available options:
 //   muEnablePPL
 //   muEnableTBB
+//   muEnableStdThreads (used if neither PPL nor TBB is enabled)
 //   muEnableISPC
 //   muEnableAMP
 //   muEnableSymbol
+//   muEnableProfile (profiling counters. see muProfileScope())
 
 #ifdef _WIN32
     #define muEnablePPL
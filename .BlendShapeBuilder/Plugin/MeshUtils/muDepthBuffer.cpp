@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "MeshUtils.h"
+
+namespace mu {
+
+void DepthBuffer::clear()
+{
+    m_width = m_height = 0;
+    m_depth.clear();
+}
+
+void DepthBuffer::build(const float4x4& mvp, const float3 *vertices, const int *indices, int num_triangles, int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_depth.resize_discard(width * height);
+    m_depth.zeroclear();
+    if (num_triangles <= 0 || width <= 0 || height <= 0) { return; }
+
+    // project vertices of triangles. x, y: pixel coordinate, z: 1/w
+    const float near_w = 1e-5f;
+    auto to_pixel = [&](const float4& cp) -> float3 {
+        float iw = 1.0f / std::max<float>(cp.w, near_w);
+        return { (cp.x * iw * 0.5f + 0.5f) * width, (cp.y * iw * 0.5f + 0.5f) * height, iw };
+    };
+    RawVector<float3> projected;
+    projected.resize_discard(num_triangles * 3);
+    parallel_for_blocked(0, num_triangles, 4096, [&](int begin, int end) {
+        for (int ti = begin; ti < end; ++ti) {
+            for (int i = 0; i < 3; ++i) {
+                float4 cp = mul4(mvp, vertices[indices[ti * 3 + i]]);
+                projected[ti * 3 + i] = cp.w > near_w ? to_pixel(cp) : float3{ 0.0f, 0.0f, -1.0f };
+            }
+        }
+    });
+
+    // clip triangles that cross the near plane in clip space. the part in front of it is a triangle or a quad,
+    // which is appended as 1 or 2 triangles.
+    for (int ti = 0; ti < num_triangles; ++ti) {
+        int num_behind = 0;
+        for (int i = 0; i < 3; ++i) {
+            if (projected[ti * 3 + i].z < 0.0f) { ++num_behind; }
+        }
+        if (num_behind == 0 || num_behind == 3) { continue; }
+
+        float4 cp[3];
+        for (int i = 0; i < 3; ++i) {
+            cp[i] = mul4(mvp, vertices[indices[ti * 3 + i]]);
+        }
+        float4 poly[4];
+        int n = 0;
+        for (int i = 0; i < 3; ++i) {
+            const float4& a = cp[i];
+            const float4& b = cp[(i + 1) % 3];
+            bool ia = a.w > near_w, ib = b.w > near_w;
+            if (ia) { poly[n++] = a; }
+            if (ia != ib) { poly[n++] = a + (b - a) * ((a.w - near_w) / (a.w - b.w)); }
+        }
+        for (int i = 1; i + 1 < n; ++i) {
+            projected.push_back(to_pixel(poly[0]));
+            projected.push_back(to_pixel(poly[i]));
+            projected.push_back(to_pixel(poly[i + 1]));
+        }
+    }
+    int num_projected = (int)projected.size() / 3;
+
+    // bin triangles into tiles
+    int tiles_x = ceildiv(width, TileSize);
+    int tiles_y = ceildiv(height, TileSize);
+    std::vector<RawVector<int>> bins(tiles_x * tiles_y);
+    for (int ti = 0; ti < num_projected; ++ti) {
+        const float3 *p = &projected[ti * 3];
+        if (p[0].z < 0.0f || p[1].z < 0.0f || p[2].z < 0.0f) { continue; }
+
+        float3 bmin = min(min(p[0], p[1]), p[2]);
+        float3 bmax = max(max(p[0], p[1]), p[2]);
+        if (bmax.x < 0.0f || bmax.y < 0.0f || bmin.x >= width || bmin.y >= height) { continue; }
+
+        int tx1 = int(clamp(bmin.x, 0.0f, float(width - 1))) / TileSize;
+        int ty1 = int(clamp(bmin.y, 0.0f, float(height - 1))) / TileSize;
+        int tx2 = int(clamp(bmax.x, 0.0f, float(width - 1))) / TileSize;
+        int ty2 = int(clamp(bmax.y, 0.0f, float(height - 1))) / TileSize;
+        for (int ty = ty1; ty <= ty2; ++ty) {
+            for (int tx = tx1; tx <= tx2; ++tx) {
+                bins[ty * tiles_x + tx].push_back(ti);
+            }
+        }
+    }
+
+    // rasterize. each tile is owned by one task so no synchronization is needed.
+    parallel_for(0, tiles_x * tiles_y, [&](int tile) {
+        int x0 = (tile % tiles_x) * TileSize;
+        int y0 = (tile / tiles_x) * TileSize;
+        int x1 = std::min<int>(x0 + TileSize, width);
+        int y1 = std::min<int>(y0 + TileSize, height);
+
+        for (int ti : bins[tile]) {
+            float3 a = projected[ti * 3 + 0];
+            float3 b = projected[ti * 3 + 1];
+            float3 c = projected[ti * 3 + 2];
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area == 0.0f) { continue; }
+            float rarea = 1.0f / area;
+
+            float3 bmin = min(min(a, b), c);
+            float3 bmax = max(max(a, b), c);
+            int px1 = (int)std::floor(clamp(bmin.x, float(x0), float(x1 - 1)));
+            int py1 = (int)std::floor(clamp(bmin.y, float(y0), float(y1 - 1)));
+            int px2 = (int)std::floor(clamp(bmax.x, float(x0), float(x1 - 1)));
+            int py2 = (int)std::floor(clamp(bmax.y, float(y0), float(y1 - 1)));
+
+            for (int py = py1; py <= py2; ++py) {
+                float y = py + 0.5f;
+                float *row = &m_depth[py * width];
+                for (int px = px1; px <= px2; ++px) {
+                    float x = px + 0.5f;
+                    // barycentric coordinates. sign of area is cancelled so both windings are accepted.
+                    float w0 = ((b.x - x) * (c.y - y) - (b.y - y) * (c.x - x)) * rarea;
+                    float w1 = ((c.x - x) * (a.y - y) - (c.y - y) * (a.x - x)) * rarea;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) { continue; }
+                    float z = a.z * w0 + b.z * w1 + c.z * w2;
+                    if (z > row[px]) { row[px] = z; }
+                }
+            }
+        }
+    });
+}
+
+bool DepthBuffer::isVisible(const float4& clip_pos, float tolerance) const
+{
+    if (empty() || clip_pos.w <= 0.0f) { return true; }
+
+    float iw = 1.0f / clip_pos.w;
+    int px = (int)std::floor((clip_pos.x * iw * 0.5f + 0.5f) * m_width);
+    int py = (int)std::floor((clip_pos.y * iw * 0.5f + 0.5f) * m_height);
+    if (px < 0 || py < 0 || px >= m_width || py >= m_height) { return true; }
+
+    // farthest surface around the pixel
+    float farthest = FLT_MAX;
+    for (int y = std::max<int>(py - 1, 0); y <= std::min<int>(py + 1, m_height - 1); ++y) {
+        for (int x = std::max<int>(px - 1, 0); x <= std::min<int>(px + 1, m_width - 1); ++x) {
+            farthest = std::min<float>(farthest, m_depth[y * m_width + x]);
+        }
+    }
+    return farthest == 0.0f || iw * (1.0f + tolerance) >= farthest;
+}
+
+} // namespace mu
@@ -0,0 +1,31 @@
+#pragma once
+
+namespace mu {
+
+// low resolution software depth buffer for visibility tests.
+// triangles are rasterized in parallel per tiles. each pixel stores 1/w of the nearest surface
+// (1/w is linear in screen space, so it can be interpolated without perspective correction).
+class DepthBuffer
+{
+public:
+    static const int TileSize = 64;
+
+    void clear();
+    // vertices are transformed by mvp and the view [-1, 1] is mapped to width x height pixels.
+    // triangles that cross the near plane are clipped against it and the parts in front of it are rasterized.
+    void build(const float4x4& mvp, const float3 *vertices, const int *indices, int num_triangles, int width, int height);
+
+    bool empty() const { return m_depth.empty(); }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    // clip_pos: mul4(mvp, vertex). true if no surface is nearer than clip_pos.w within tolerance (relative to depth).
+    // neighbor pixels are also tested to tolerate sampling errors on slopes and silhouettes.
+    bool isVisible(const float4& clip_pos, float tolerance = 0.005f) const;
+
+private:
+    int m_width = 0, m_height = 0;
+    RawVector<float> m_depth; // 1/w. 0 means empty
+};
+
+} // namespace mu
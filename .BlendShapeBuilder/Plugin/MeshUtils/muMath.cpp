@@ -24,6 +24,110 @@ void HalfToFloat_Generic(float *dst, const half *src, size_t num)
 }
 #endif // muEnableHalf
 
+// round to nearest even. based on "float->half variants" by Fabian Giesen.
+static inline uint16_t FloatToHalfBits1(float v)
+{
+    const uint32_t f32infty = 255u << 23;
+    const uint32_t f16max = (127u + 16u) << 23;
+    const uint32_t denorm_magic_u = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    float denorm_magic;
+    memcpy(&denorm_magic, &denorm_magic_u, 4);
+
+    uint32_t f;
+    memcpy(&f, &v, 4);
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint32_t ret;
+    if (f >= f16max) {
+        // inf or nan
+        ret = f > f32infty ? 0x7e00 : 0x7c00;
+    }
+    else if (f < (113u << 23)) {
+        // denormal or zero. let the FPU do the rounding.
+        float t;
+        memcpy(&t, &f, 4);
+        t += denorm_magic;
+        memcpy(&ret, &t, 4);
+        ret -= denorm_magic_u;
+    }
+    else {
+        uint32_t mant_odd = (f >> 13) & 1;
+        f += ((uint32_t)(15 - 127) << 23) + 0xfff;
+        f += mant_odd;
+        ret = f >> 13;
+    }
+    return (uint16_t)(ret | (sign >> 16));
+}
+
+static inline float HalfBitsToFloat1(uint16_t h)
+{
+    const uint32_t shifted_exp = 0x7c00u << 13;
+    const uint32_t magic_u = 113u << 23;
+
+    uint32_t ret = (uint32_t)(h & 0x7fff) << 13;
+    uint32_t exp = shifted_exp & ret;
+    ret += (127u - 15u) << 23;
+    if (exp == shifted_exp) {
+        // inf or nan
+        ret += (128u - 16u) << 23;
+    }
+    else if (exp == 0) {
+        // denormal or zero
+        float magic, t;
+        memcpy(&magic, &magic_u, 4);
+        ret += 1u << 23;
+        memcpy(&t, &ret, 4);
+        t -= magic;
+        memcpy(&ret, &t, 4);
+    }
+    ret |= (uint32_t)(h & 0x8000) << 16;
+
+    float f;
+    memcpy(&f, &ret, 4);
+    return f;
+}
+
+void FloatToHalfBits_Generic(uint16_t *dst, const float *src, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = FloatToHalfBits1(src[i]);
+    }
+}
+void HalfBitsToFloat_Generic(float *dst, const uint16_t *src, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = HalfBitsToFloat1(src[i]);
+    }
+}
+
+void QuantizePoints_Generic(uint16_t *dst, const float3 *src, size_t num, float3 bmin, float3 bmax)
+{
+    float3 extent = bmax - bmin;
+    float3 scale = {
+        extent.x > 0.0f ? 65535.0f / extent.x : 0.0f,
+        extent.y > 0.0f ? 65535.0f / extent.y : 0.0f,
+        extent.z > 0.0f ? 65535.0f / extent.z : 0.0f,
+    };
+    for (size_t i = 0; i < num; ++i) {
+        float3 q = (src[i] - bmin) * scale;
+        dst[i * 3 + 0] = (uint16_t)(clamp(q.x, 0.0f, 65535.0f) + 0.5f);
+        dst[i * 3 + 1] = (uint16_t)(clamp(q.y, 0.0f, 65535.0f) + 0.5f);
+        dst[i * 3 + 2] = (uint16_t)(clamp(q.z, 0.0f, 65535.0f) + 0.5f);
+    }
+}
+void DequantizePoints_Generic(float3 *dst, const uint16_t *src, size_t num, float3 bmin, float3 bmax)
+{
+    float3 scale = (bmax - bmin) * (1.0f / 65535.0f);
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = {
+            bmin.x + (float)src[i * 3 + 0] * scale.x,
+            bmin.y + (float)src[i * 3 + 1] * scale.y,
+            bmin.z + (float)src[i * 3 + 2] * scale.z,
+        };
+    }
+}
+
 void InvertX_Generic(float3 *dst, size_t num)
 {
     for (size_t i = 0; i < num; ++i) {
@@ -98,6 +202,34 @@ void MinMax_Generic(const float3 *src, size_t num, float3& dst_min, float3& dst_
     dst_max = rmax;
 }
 
+void GenerateDelta_Generic(float *dst, const float *base, const float *target, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = target[i] - base[i];
+    }
+}
+
+void GenerateDelta_Generic(float3 *dst, const float4 *base, const float4 *target, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = { target[i].x - base[i].x, target[i].y - base[i].y, target[i].z - base[i].z };
+    }
+}
+
+void MulAddIndexed_Generic(float3 *dst, const float3 *src, const int *indices, float w, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[indices[i]] += src[i] * w;
+    }
+}
+
+void MulAddIndexed_Generic(float4 *dst, const float3 *src, const int *indices, float w, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        (float3&)dst[indices[i]] += src[i] * w;
+    }
+}
+
 bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float eps)
 {
     for (size_t i = 0; i < num; ++i) {
@@ -108,6 +240,16 @@ bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float e
     return true;
 }
 
+bool NearZero_Generic(const float *src, size_t num, float eps)
+{
+    for (size_t i = 0; i < num; ++i) {
+        if (!near_equal(src[i], 0.0f, eps)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void MulPoints_Generic(const float4x4& m, const float3 src[], float3 dst[], size_t num_data)
 {
     for (int i = 0; i < num_data; ++i) {
@@ -120,6 +262,111 @@ void MulVectors_Generic(const float4x4& m, const float3 src[], float3 dst[], siz
         dst[i] = mul_v(m, src[i]);
     }
 }
+void ProjectPoints_Generic(const float4x4& m, const float3 src[], float dst_x[], float dst_y[], float dst_z[], float dst_w[], size_t num_data)
+{
+    for (size_t i = 0; i < num_data; ++i) {
+        float4 r = mul4(m, src[i]);
+        dst_x[i] = r.x / r.w;
+        dst_y[i] = r.y / r.w;
+        dst_z[i] = r.z;
+        dst_w[i] = r.w;
+    }
+}
+
+void MulPointsSoA_Generic(const float4x4& m, const float src_x[], const float src_y[], const float src_z[],
+    float dst_x[], float dst_y[], float dst_z[], size_t num_data)
+{
+    for (size_t i = 0; i < num_data; ++i) {
+        float3 r = mul_p(m, float3{ src_x[i], src_y[i], src_z[i] });
+        dst_x[i] = r.x;
+        dst_y[i] = r.y;
+        dst_z[i] = r.z;
+    }
+}
+
+int SelectInsideSoA_Generic(const float4x4& m, const float src_x[], const float src_y[], const float src_z[], const int indices[], size_t num_data,
+    float3 pos, float radius, int dst_indices[], float dst_distances[])
+{
+    // compute distances and compact the results separately so that the compiler can vectorize the former
+    const size_t block_size = 64;
+    float dsq[block_size];
+    float rq = radius * radius;
+    int ret = 0;
+    for (size_t bi = 0; bi < num_data; bi += block_size) {
+        size_t n = std::min(num_data - bi, block_size);
+        if (indices) {
+            for (size_t i = 0; i < n; ++i) {
+                int vi = indices[bi + i];
+                dsq[i] = length_sq(mul_p(m, float3{ src_x[vi], src_y[vi], src_z[vi] }) - pos);
+            }
+        }
+        else {
+            for (size_t i = 0; i < n; ++i) {
+                size_t vi = bi + i;
+                dsq[i] = length_sq(mul_p(m, float3{ src_x[vi], src_y[vi], src_z[vi] }) - pos);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (dsq[i] <= rq) {
+                dst_indices[ret] = indices ? indices[bi + i] : (int)(bi + i);
+                dst_distances[ret] = std::sqrt(dsq[i]);
+                ++ret;
+            }
+        }
+    }
+    return ret;
+}
+
+template<int N>
+static inline void SkinningImpl(const float4x4 poses[], const Weights<N> weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    bool do_points = ipoints && opoints;
+    bool do_normals = inormals && onormals;
+    bool do_tangents = itangents && otangents;
+    for (size_t vi = 0; vi < num; ++vi) {
+        const auto& w = weights[vi];
+        if (do_points) {
+            float3 p = ipoints[vi];
+            float3 rp = float3::zero();
+            for (int bi = 0; bi < N; ++bi) {
+                rp += mul_p(poses[w.indices[bi]], p) * w.weights[bi];
+            }
+            opoints[vi] = rp;
+        }
+        if (do_normals) {
+            float3 n = inormals[vi];
+            float3 rn = float3::zero();
+            for (int bi = 0; bi < N; ++bi) {
+                rn += mul_v(poses[w.indices[bi]], n) * w.weights[bi];
+            }
+            onormals[vi] = normalize(rn);
+        }
+        if (do_tangents) {
+            float4 t = itangents[vi];
+            float4 rt = float4::zero();
+            for (int bi = 0; bi < N; ++bi) {
+                rt += mul_v(poses[w.indices[bi]], t) * w.weights[bi];
+            }
+            otangents[vi] = rt;
+        }
+    }
+}
+
+void Skinning_Generic(const float4x4 poses[], const Weights4 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    SkinningImpl(poses, weights, ipoints, inormals, itangents, opoints, onormals, otangents, num);
+}
+
+void Skinning_Generic(const float4x4 poses[], const Weights8 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    SkinningImpl(poses, weights, ipoints, inormals, itangents, opoints, onormals, otangents, num);
+}
 
 int RayTrianglesIntersectionIndexed_Generic(float3 pos, float3 dir, const float3 *vertices, const int *indices, int num_triangles, int& tindex, float& distance)
 {
@@ -3,6 +3,23 @@
 
 namespace mu {
 
+// vertices with more connected faces than this have hash tables for findOrAddVertex*(). scanning is faster on others.
+static const int HashedDedupThreshold = 16;
+
+static inline uint32_t HashVertex(uint32_t h) { return h; }
+
+// FNV-1a on 32 bit words. hashes exact bit patterns, so near-equal attributes usually have different hashes.
+template<class T, class... Rest>
+static inline uint32_t HashVertex(uint32_t h, const T& v, const Rest&... rest)
+{
+    static_assert(sizeof(T) % 4 == 0, "");
+    auto *words = (const uint32_t*)&v;
+    for (size_t i = 0; i < sizeof(T) / 4; ++i) {
+        h = (h ^ words[i]) * 16777619u;
+    }
+    return HashVertex(h, rest...);
+}
+
 void MeshRefiner::prepare(
     const IArray<int>& counts_, const IArray<int>& indices_, const IArray<float3>& points_)
 {
@@ -298,6 +315,28 @@ void MeshRefiner::doRefine(const Body& body)
     old2new_indices.resize(num_indices, -1);
 
     int num_faces_total = (int)counts.size();
+
+    // per-vertex tables. a vertex can't be split into more than the number of connected faces,
+    // so the load factor of a table never exceeds 0.5.
+    int num_points = (int)points.size();
+    table_offsets.resize_discard(num_points + 1);
+    int table_size = 0;
+    for (int vi = 0; vi < num_points; ++vi) {
+        table_offsets[vi] = table_size;
+        int count = connection.v2f_counts[vi];
+        if (count > HashedDedupThreshold) {
+            int size = 64;
+            while (size < count * 2) { size *= 2; }
+            table_size += size;
+        }
+    }
+    table_offsets[num_points] = table_size;
+    vertex_table.resize_discard(table_size);
+    vertex_table_hashes.resize_discard(table_size);
+    std::fill(vertex_table.begin(), vertex_table.end(), -1);
+    split_slots.clear();
+    table_vertices.clear();
+
     int offset_faces = 0;
     int offset_indices = 0;
     int offset_vertices = 0;
@@ -328,9 +367,7 @@ void MeshRefiner::doRefine(const Body& body)
 
         if (split_unit > 0 && (int)new_points.size() - offset_vertices + count > split_unit) {
             add_new_split();
-
-            // clear vertex cache
-            std::fill(old2new_indices.begin(), old2new_indices.end(), -1);
+            clearVertexCache();
         }
 
         for (int ci = 0; ci < count; ++ci) {
@@ -345,24 +382,25 @@ void MeshRefiner::doRefine(const Body& body)
     add_new_split();
 
     if (triangulate) {
+        int num_splits = (int)splits.size();
+        RawVector<int> offsets_triangulated;
+        offsets_triangulated.resize_discard(num_splits);
         int nindices = 0;
-        for (auto& split : splits) {
-            nindices += split.num_indices_triangulated;
+        for (int si = 0; si < num_splits; ++si) {
+            offsets_triangulated[si] = nindices;
+            nindices += splits[si].num_indices_triangulated;
         }
 
+        // splits are independent once their offsets are known
         new_indices_triangulated.resize(nindices);
-        int *sub_indices = new_indices_triangulated.data();
-        int *n_counts = counts.data();
-        int *n_indices = new_indices.data();
-        for (auto& split : splits) {
+        parallel_for(0, num_splits, [&](int si) {
+            auto& split = splits[si];
+            int *sub_indices = &new_indices_triangulated[offsets_triangulated[si]];
             mu::TriangulateWithIndices(sub_indices,
-                IntrusiveArray<int>(n_counts, split.num_faces),
-                IntrusiveArray<int>(n_indices, split.num_indices),
+                IntrusiveArray<int>(&counts[split.offset_faces], split.num_faces),
+                IntrusiveArray<int>(&new_indices[split.offset_indices], split.num_indices),
                 swap_faces);
-            sub_indices += split.num_indices_triangulated;
-            n_counts += split.num_faces;
-            n_indices += split.num_indices;
-        }
+        });
     }
     else if (swap_faces) {
         // todo
@@ -528,10 +566,56 @@ void MeshRefiner::buildConnection()
     connection.buildConnection(indices, counts, offsets, points);
 }
 
+void MeshRefiner::clearVertexCache()
+{
+    for (int slot : split_slots) {
+        old2new_indices[slot] = -1;
+    }
+    split_slots.clear();
+    for (int vi : table_vertices) {
+        std::fill(&vertex_table[table_offsets[vi]], &vertex_table[table_offsets[vi + 1]], -1);
+    }
+    table_vertices.clear();
+}
+
+template<class Equal>
+inline int MeshRefiner::findVertex(int vi, uint32_t hash, const Equal& equal) const
+{
+    int offset = table_offsets[vi];
+    int mask = table_offsets[vi + 1] - offset - 1;
+    for (int i = (int)(hash & (uint32_t)mask); ; i = (i + 1) & mask) {
+        int ni = vertex_table[offset + i];
+        if (ni == -1) { return -1; }
+        if (vertex_table_hashes[offset + i] == hash && equal(ni)) { return ni; }
+    }
+}
+
+void MeshRefiner::addVertex(int vi, uint32_t hash, int ni)
+{
+    int offset = table_offsets[vi];
+    int mask = table_offsets[vi + 1] - offset - 1;
+    int i = (int)(hash & (uint32_t)mask);
+    while (vertex_table[offset + i] != -1) { i = (i + 1) & mask; }
+    vertex_table[offset + i] = ni;
+    vertex_table_hashes[offset + i] = hash;
+}
+
+// the table finds exact matches. an exact match is always the first near-equal candidate, because a vertex
+// is added only when no candidates are near-equal to it. others fall back to scanning candidates.
+
 int MeshRefiner::findOrAddVertexPNTUC(int vi, const float3& p, const float3& n, const float4& t, const float2& u, const float4& c)
 {
     int offset = connection.v2f_offsets[vi];
     int count = connection.v2f_counts[vi];
+    uint32_t hash = 0;
+    bool hashed = count > HashedDedupThreshold;
+    if (hashed) {
+        hash = HashVertex(2166136261u, p, n, u, c);
+        int found = findVertex(vi, hash, [&](int ni) {
+            return new_points[ni] == p && new_normals[ni] == n && new_uv[ni] == u && new_colors[ni] == c;
+        });
+        if (found != -1) { return found; }
+    }
     for (int ci = 0; ci < count; ++ci) {
         int& ni = old2new_indices[connection.v2f_indices[offset + ci]];
         // tangent can be omitted as it is generated by point, normal and uv
@@ -541,6 +625,11 @@ int MeshRefiner::findOrAddVertexPNTUC(int vi, const float3& p, const float3& n,
         else if (ni == -1) {
             new2old_vertices.push_back(vi);
             ni = (int)new_points.size();
+            split_slots.push_back(connection.v2f_indices[offset + ci]);
+            if (hashed) {
+                if (ci == 0) { table_vertices.push_back(vi); } // the first vertex split from vi in the current split
+                addVertex(vi, hash, ni);
+            }
             new_points.push_back(p);
             new_normals.push_back(n);
             new_tangents.push_back(t);
@@ -556,6 +645,15 @@ int MeshRefiner::findOrAddVertexPNTU(int vi, const float3& p, const float3& n, c
 {
     int offset = connection.v2f_offsets[vi];
     int count = connection.v2f_counts[vi];
+    uint32_t hash = 0;
+    bool hashed = count > HashedDedupThreshold;
+    if (hashed) {
+        hash = HashVertex(2166136261u, p, n, u);
+        int found = findVertex(vi, hash, [&](int ni) {
+            return new_points[ni] == p && new_normals[ni] == n && new_uv[ni] == u;
+        });
+        if (found != -1) { return found; }
+    }
     for (int ci = 0; ci < count; ++ci) {
         int& ni = old2new_indices[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n) && near_equal(new_uv[ni], u)) {
@@ -564,6 +662,11 @@ int MeshRefiner::findOrAddVertexPNTU(int vi, const float3& p, const float3& n, c
         else if (ni == -1) {
             new2old_vertices.push_back(vi);
             ni = (int)new_points.size();
+            split_slots.push_back(connection.v2f_indices[offset + ci]);
+            if (hashed) {
+                if (ci == 0) { table_vertices.push_back(vi); } // the first vertex split from vi in the current split
+                addVertex(vi, hash, ni);
+            }
             new_points.push_back(p);
             new_normals.push_back(n);
             new_tangents.push_back(t);
@@ -578,6 +681,15 @@ int MeshRefiner::findOrAddVertexPNU(int vi, const float3& p, const float3& n, co
 {
     int offset = connection.v2f_offsets[vi];
     int count = connection.v2f_counts[vi];
+    uint32_t hash = 0;
+    bool hashed = count > HashedDedupThreshold;
+    if (hashed) {
+        hash = HashVertex(2166136261u, p, n, u);
+        int found = findVertex(vi, hash, [&](int ni) {
+            return new_points[ni] == p && new_normals[ni] == n && new_uv[ni] == u;
+        });
+        if (found != -1) { return found; }
+    }
     for (int ci = 0; ci < count; ++ci) {
         int& ni = old2new_indices[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n) && near_equal(new_uv[ni], u)) {
@@ -586,6 +698,11 @@ int MeshRefiner::findOrAddVertexPNU(int vi, const float3& p, const float3& n, co
         else if (ni == -1) {
             new2old_vertices.push_back(vi);
             ni = (int)new_points.size();
+            split_slots.push_back(connection.v2f_indices[offset + ci]);
+            if (hashed) {
+                if (ci == 0) { table_vertices.push_back(vi); } // the first vertex split from vi in the current split
+                addVertex(vi, hash, ni);
+            }
             new_points.push_back(p);
             new_normals.push_back(n);
             new_uv.push_back(u);
@@ -599,6 +716,15 @@ int MeshRefiner::findOrAddVertexPN(int vi, const float3& p, const float3& n)
 {
     int offset = connection.v2f_offsets[vi];
     int count = connection.v2f_counts[vi];
+    uint32_t hash = 0;
+    bool hashed = count > HashedDedupThreshold;
+    if (hashed) {
+        hash = HashVertex(2166136261u, p, n);
+        int found = findVertex(vi, hash, [&](int ni) {
+            return new_points[ni] == p && new_normals[ni] == n;
+        });
+        if (found != -1) { return found; }
+    }
     for (int ci = 0; ci < count; ++ci) {
         int& ni = old2new_indices[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n)) {
@@ -607,6 +733,11 @@ int MeshRefiner::findOrAddVertexPN(int vi, const float3& p, const float3& n)
         else if (ni == -1) {
             new2old_vertices.push_back(vi);
             ni = (int)new_points.size();
+            split_slots.push_back(connection.v2f_indices[offset + ci]);
+            if (hashed) {
+                if (ci == 0) { table_vertices.push_back(vi); } // the first vertex split from vi in the current split
+                addVertex(vi, hash, ni);
+            }
             new_points.push_back(p);
             new_normals.push_back(n);
             return ni;
@@ -619,6 +750,15 @@ int MeshRefiner::findOrAddVertexPU(int vi, const float3& p, const float2& u)
 {
     int offset = connection.v2f_offsets[vi];
     int count = connection.v2f_counts[vi];
+    uint32_t hash = 0;
+    bool hashed = count > HashedDedupThreshold;
+    if (hashed) {
+        hash = HashVertex(2166136261u, p, u);
+        int found = findVertex(vi, hash, [&](int ni) {
+            return new_points[ni] == p && new_uv[ni] == u;
+        });
+        if (found != -1) { return found; }
+    }
     for (int ci = 0; ci < count; ++ci) {
         int& ni = old2new_indices[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_uv[ni], u)) {
@@ -627,6 +767,11 @@ int MeshRefiner::findOrAddVertexPU(int vi, const float3& p, const float2& u)
         else if (ni == -1) {
             new2old_vertices.push_back(vi);
             ni = (int)new_points.size();
+            split_slots.push_back(connection.v2f_indices[offset + ci]);
+            if (hashed) {
+                if (ci == 0) { table_vertices.push_back(vi); } // the first vertex split from vi in the current split
+                addVertex(vi, hash, ni);
+            }
             new_points.push_back(p);
             new_uv.push_back(u);
             return ni;
@@ -58,6 +58,14 @@ private:
     RawVector<int>    dummy_materialIDs;
     int num_indices_tri = 0;
 
+    // per-vertex open addressing tables of vertices in the current split, keyed by hash of exact attributes.
+    // lets findOrAddVertex*() skip scanning candidates on heavily seamed vertices.
+    RawVector<int>      table_offsets; // region of each vertex in vertex_table. empty if the vertex has few connected faces
+    RawVector<int>      vertex_table;
+    RawVector<uint32_t> vertex_table_hashes;
+    RawVector<int>      table_vertices; // vertices that have entries in the current split
+    RawVector<int>      split_slots; // entries of old2new_indices set in the current split
+
 public:
     void prepare(const IArray<int>& counts, const IArray<int>& indices, const IArray<float3>& points);
     void genNormals(bool flip);
@@ -83,6 +91,9 @@ private:
     void buildConnection();
 
     template<class Body> void doRefine(const Body& body);
+    void clearVertexCache();
+    template<class Equal> int findVertex(int vi, uint32_t hash, const Equal& equal) const;
+    void addVertex(int vi, uint32_t hash, int ni);
     int findOrAddVertexPNTUC(int vi, const float3& p, const float3& n, const float4& t, const float2& u, const float4& c);
     int findOrAddVertexPNTU(int vi, const float3& p, const float3& n, const float4& t, const float2& u);
     int findOrAddVertexPNU(int vi, const float3& p, const float3& n, const float2& u);
@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "muMisc.h"
+#include "muTLS.h"
+#include <atomic>
+#include <mutex>
 #ifdef _WIN32
     #include <dbghelp.h>
     #include <psapi.h>
@@ -17,6 +20,97 @@ nanosec Now()
     return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
+#ifdef muEnableProfile
+namespace {
+
+const int MaxProfileCounters = 256;
+
+// written only by the owner thread. atomics are to make reading from other threads well-defined.
+struct ProfileSlot
+{
+    std::atomic<uint64_t> num_calls{ 0 };
+    std::atomic<uint64_t> num_elements{ 0 };
+    std::atomic<uint64_t> total_time{ 0 };
+    std::atomic<uint64_t> max_time{ 0 };
+};
+
+struct ProfileSlots
+{
+    ProfileSlot slots[MaxProfileCounters];
+};
+
+std::mutex g_profile_mutex;
+const char *g_profile_names[MaxProfileCounters];
+std::atomic_int g_num_profile_counters{ 0 };
+tls<ProfileSlots> g_profile_slots;
+
+} // namespace
+
+int ProfileRegister(const char *name)
+{
+    std::unique_lock<std::mutex> lock(g_profile_mutex);
+    int n = g_num_profile_counters;
+    for (int i = 0; i < n; ++i) {
+        if (strcmp(g_profile_names[i], name) == 0) { return i; }
+    }
+    if (n == MaxProfileCounters) { return -1; }
+    g_profile_names[n] = name;
+    g_num_profile_counters = n + 1;
+    return n;
+}
+
+void ProfileAdd(int id, nanosec elapsed, uint64_t num_elements)
+{
+    if (id < 0) { return; }
+    auto& slot = g_profile_slots.local().slots[id];
+    auto relaxed = std::memory_order_relaxed;
+    slot.num_calls.store(slot.num_calls.load(relaxed) + 1, relaxed);
+    slot.num_elements.store(slot.num_elements.load(relaxed) + num_elements, relaxed);
+    slot.total_time.store(slot.total_time.load(relaxed) + elapsed, relaxed);
+    if (elapsed > slot.max_time.load(relaxed)) {
+        slot.max_time.store(elapsed, relaxed);
+    }
+}
+
+int ProfileGetStats(ProfileStats *dst, int max_stats)
+{
+    int n = g_num_profile_counters;
+    if (!dst) { return n; }
+
+    n = std::min(n, max_stats);
+    for (int i = 0; i < n; ++i) {
+        dst[i] = ProfileStats();
+        dst[i].name = g_profile_names[i];
+    }
+    auto relaxed = std::memory_order_relaxed;
+    g_profile_slots.each([&](ProfileSlots& slots) {
+        for (int i = 0; i < n; ++i) {
+            auto& slot = slots.slots[i];
+            auto& d = dst[i];
+            d.num_calls += slot.num_calls.load(relaxed);
+            d.num_elements += slot.num_elements.load(relaxed);
+            d.total_time += slot.total_time.load(relaxed);
+            d.max_time = std::max<nanosec>(d.max_time, slot.max_time.load(relaxed));
+        }
+    });
+    return n;
+}
+
+void ProfileReset()
+{
+    // measurements in progress on other threads may survive. it is not worth locking for.
+    auto relaxed = std::memory_order_relaxed;
+    g_profile_slots.each([&](ProfileSlots& slots) {
+        for (auto& slot : slots.slots) {
+            slot.num_calls.store(0, relaxed);
+            slot.num_elements.store(0, relaxed);
+            slot.total_time.store(0, relaxed);
+            slot.max_time.store(0, relaxed);
+        }
+    });
+}
+#endif // muEnableProfile
+
 void Print(const char *fmt, ...)
 {
     va_list args;
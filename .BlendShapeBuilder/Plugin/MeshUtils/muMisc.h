@@ -9,6 +9,48 @@ using nanosec = uint64_t;
 nanosec Now();
 inline float NS2MS(nanosec ns) { return (float)((double)ns / 1000000.0); }
 
+
+// profiling counters. muProfileScope(name, num_elements) measures the rest of the enclosing scope and
+// accumulates call count, total / max time and number of processed elements to the counter of name.
+// counters are per-thread, so measuring doesn't involve locks. compiled to nothing if muEnableProfile is not defined.
+#ifdef muEnableProfile
+struct ProfileStats
+{
+    const char *name = nullptr;
+    uint64_t num_calls = 0;
+    uint64_t num_elements = 0;
+    nanosec total_time = 0;
+    nanosec max_time = 0;
+};
+
+// returns id of the counter of name (must be a static string). counters with same name are shared.
+int ProfileRegister(const char *name);
+void ProfileAdd(int id, nanosec elapsed, uint64_t num_elements);
+// dst (optional) receives stats of counters summed up over threads. returns the number of counters.
+int ProfileGetStats(ProfileStats *dst, int max_stats);
+void ProfileReset();
+
+class ProfileScope
+{
+public:
+    ProfileScope(int id, uint64_t num_elements) : m_id(id), m_num_elements(num_elements), m_begin(Now()) {}
+    ~ProfileScope() { ProfileAdd(m_id, Now() - m_begin, m_num_elements); }
+
+private:
+    int m_id;
+    uint64_t m_num_elements;
+    nanosec m_begin;
+};
+
+#define muProfileConcat2(A, B) A##B
+#define muProfileConcat(A, B) muProfileConcat2(A, B)
+#define muProfileScope(Name, NumElements)\
+    static const int muProfileConcat(mu_profile_id_, __LINE__) = mu::ProfileRegister(Name);\
+    mu::ProfileScope muProfileConcat(mu_profile_scope_, __LINE__)(muProfileConcat(mu_profile_id_, __LINE__), (uint64_t)(NumElements))
+#else
+#define muProfileScope(Name, NumElements)
+#endif
+
 void Print(const char *fmt, ...);
 void Print(const wchar_t *fmt, ...);
 
@@ -4,7 +4,8 @@
 #include <initializer_list>
 #include "muAllocator.h"
 
-template<class T, int Align = 0x20>
+// Allocator: HeapAllocator or ScratchAllocator (see muAllocator.h)
+template<class T, int Align = 0x20, class Allocator = HeapAllocator>
 class RawVector
 {
 public:
@@ -76,8 +77,8 @@ public:
     iterator end() { return m_data + m_size; }
     const_iterator end() const { return m_data + m_size; }
 
-    static void* allocate(size_t size) { return AlignedMalloc(size, alignment); }
-    static void deallocate(void *addr, size_t /*size*/) { AlignedFree(addr); }
+    static void* allocate(size_t size) { return Allocator::allocate(size, alignment); }
+    static void deallocate(void *addr, size_t /*size*/) { Allocator::deallocate(addr); }
 
     void reserve(size_t s)
     {
@@ -111,6 +112,7 @@ public:
     {
         if (m_size == 0) {
             deallocate(m_data, m_size);
+            m_data = nullptr;
             m_size = m_capacity = 0;
         }
         else if (m_size == m_capacity) {
@@ -260,3 +262,7 @@ private:
     size_t m_size = 0;
     size_t m_capacity = 0;
 };
+
+// RawVector for temporaries of API calls. see ScratchScope.
+template<class T>
+using ScratchVector = RawVector<T, 0x20, ScratchAllocator>;
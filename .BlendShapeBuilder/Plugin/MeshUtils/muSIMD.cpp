@@ -23,6 +23,30 @@ void HalfToFloat_ISPC(float *dst, const half *src, size_t num)
 }
 #endif
 #endif // muEnableHalf
+#ifdef muSIMD_FloatToHalfBits
+void FloatToHalfBits_ISPC(uint16_t *dst, const float *src, size_t num)
+{
+    ispc::FloatToHalf(dst, src, (int)num);
+}
+#endif
+#ifdef muSIMD_HalfBitsToFloat
+void HalfBitsToFloat_ISPC(float *dst, const uint16_t *src, size_t num)
+{
+    ispc::HalfToFloat(dst, src, (int)num);
+}
+#endif
+#ifdef muSIMD_QuantizePoints
+void QuantizePoints_ISPC(uint16_t *dst, const float3 *src, size_t num, float3 bmin, float3 bmax)
+{
+    ispc::QuantizePoints(dst, (ispc::float3*)src, (int)num, (ispc::float3&)bmin, (ispc::float3&)bmax);
+}
+#endif
+#ifdef muSIMD_DequantizePoints
+void DequantizePoints_ISPC(float3 *dst, const uint16_t *src, size_t num, float3 bmin, float3 bmax)
+{
+    ispc::DequantizePoints((ispc::float3*)dst, src, (int)num, (ispc::float3&)bmin, (ispc::float3&)bmax);
+}
+#endif
 
 #ifdef muSIMD_InvertX3
 void InvertX_ISPC(float3 *dst, size_t num)
@@ -64,6 +88,32 @@ void Lerp_ISPC(float *dst, const float *src1, const float *src2, size_t num, flo
 }
 #endif
 
+#ifdef muSIMD_GenerateDelta
+void GenerateDelta_ISPC(float *dst, const float *base, const float *target, size_t num)
+{
+    ispc::GenerateDelta(dst, base, target, (int)num);
+}
+#endif
+#ifdef muSIMD_GenerateDelta4
+void GenerateDelta_ISPC(float3 *dst, const float4 *base, const float4 *target, size_t num)
+{
+    ispc::GenerateDelta4((ispc::float3*)dst, (ispc::float4*)base, (ispc::float4*)target, (int)num);
+}
+#endif
+
+#ifdef muSIMD_MulAddIndexed3
+void MulAddIndexed_ISPC(float3 *dst, const float3 *src, const int *indices, float w, size_t num)
+{
+    ispc::MulAddIndexed3((ispc::float3*)dst, (ispc::float3*)src, indices, w, (int)num);
+}
+#endif
+#ifdef muSIMD_MulAddIndexed4
+void MulAddIndexed_ISPC(float4 *dst, const float3 *src, const int *indices, float w, size_t num)
+{
+    ispc::MulAddIndexed4((ispc::float4*)dst, (ispc::float3*)src, indices, w, (int)num);
+}
+#endif
+
 #ifdef muSIMD_NearEqual
 bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps)
 {
@@ -71,6 +121,13 @@ bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps)
 }
 #endif
 
+#ifdef muSIMD_NearZero
+bool NearZero_ISPC(const float *src, size_t num, float eps)
+{
+    return ispc::NearZero(src, (int)num, eps);
+}
+#endif
+
 #ifdef muSIMD_MinMax2
 void MinMax_ISPC(const float2 *src, size_t num, float2& dst_min, float2& dst_max)
 {
@@ -98,6 +155,56 @@ void MulVectors_ISPC(const float4x4& m, const float3 src[], float3 dst[], size_t
     ispc::MulVectors3((ispc::float4x4&)m, (ispc::float3*)src, (ispc::float3*)dst, (int)num_data);
 }
 #endif
+#ifdef muSIMD_ProjectPoints
+void ProjectPoints_ISPC(const float4x4& m, const float3 src[], float dst_x[], float dst_y[], float dst_z[], float dst_w[], size_t num_data)
+{
+    ispc::ProjectPoints((ispc::float4x4&)m, (ispc::float3*)src, dst_x, dst_y, dst_z, dst_w, (int)num_data);
+}
+#endif
+#ifdef muSIMD_MulPointsSoA
+void MulPointsSoA_ISPC(const float4x4& m, const float src_x[], const float src_y[], const float src_z[],
+    float dst_x[], float dst_y[], float dst_z[], size_t num_data)
+{
+    ispc::MulPointsSoA((ispc::float4x4&)m, src_x, src_y, src_z, dst_x, dst_y, dst_z, (int)num_data);
+}
+#endif
+#ifdef muSIMD_SelectInsideSoA
+int SelectInsideSoA_ISPC(const float4x4& m, const float src_x[], const float src_y[], const float src_z[], const int indices[], size_t num_data,
+    float3 pos, float radius, int dst_indices[], float dst_distances[])
+{
+    return ispc::SelectInsideSoA((ispc::float4x4&)m, src_x, src_y, src_z, indices, (int)num_data,
+        (ispc::float3&)pos, radius, dst_indices, dst_distances);
+}
+#endif
+
+#if defined(muSIMD_Skinning4) || defined(muSIMD_Skinning8)
+template<int N>
+static inline void SkinningISPCImpl(const float4x4 poses[], const Weights<N> weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    // Weights<N> is float[N] followed by int[N]
+    ispc::Skinning((ispc::float4x4*)poses, (const float*)weights, (const int*)weights + N, N * 2, N,
+        (ispc::float3*)ipoints, (ispc::float3*)inormals, (ispc::float4*)itangents,
+        (ispc::float3*)opoints, (ispc::float3*)onormals, (ispc::float4*)otangents, (int)num);
+}
+#endif
+#ifdef muSIMD_Skinning4
+void Skinning_ISPC(const float4x4 poses[], const Weights4 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    SkinningISPCImpl(poses, weights, ipoints, inormals, itangents, opoints, onormals, otangents, num);
+}
+#endif
+#ifdef muSIMD_Skinning8
+void Skinning_ISPC(const float4x4 poses[], const Weights8 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    SkinningISPCImpl(poses, weights, ipoints, inormals, itangents, opoints, onormals, otangents, num);
+}
+#endif
 
 
 #ifdef muSIMD_RayTrianglesIntersectionIndexed
@@ -263,6 +370,30 @@ void HalfToFloat(float *dst, const half *src, size_t num)
 }
 #endif
 #endif // muEnableHalf
+#if defined(muSIMD_FloatToHalfBits) || !defined(muEnableISPC)
+void FloatToHalfBits(uint16_t *dst, const float *src, size_t num)
+{
+    Forward(FloatToHalfBits, dst, src, num);
+}
+#endif
+#if defined(muSIMD_HalfBitsToFloat) || !defined(muEnableISPC)
+void HalfBitsToFloat(float *dst, const uint16_t *src, size_t num)
+{
+    Forward(HalfBitsToFloat, dst, src, num);
+}
+#endif
+#if defined(muSIMD_QuantizePoints) || !defined(muEnableISPC)
+void QuantizePoints(uint16_t *dst, const float3 *src, size_t num, float3 bmin, float3 bmax)
+{
+    Forward(QuantizePoints, dst, src, num, bmin, bmax);
+}
+#endif
+#if defined(muSIMD_DequantizePoints) || !defined(muEnableISPC)
+void DequantizePoints(float3 *dst, const uint16_t *src, size_t num, float3 bmin, float3 bmax)
+{
+    Forward(DequantizePoints, dst, src, num, bmin, bmax);
+}
+#endif
 
 #if defined(muSIMD_InvertX3) || !defined(muEnableISPC)
 void InvertX(float3 *dst, size_t num)
@@ -316,6 +447,38 @@ void Lerp(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float
 }
 #endif
 
+#if defined(muSIMD_GenerateDelta) || !defined(muEnableISPC)
+void GenerateDelta(float *dst, const float *base, const float *target, size_t num)
+{
+    Forward(GenerateDelta, dst, base, target, num);
+}
+#endif
+#if defined(muSIMD_GenerateDelta) || !defined(muEnableISPC)
+void GenerateDelta(float3 *dst, const float3 *base, const float3 *target, size_t num)
+{
+    GenerateDelta((float*)dst, (const float*)base, (const float*)target, num * 3);
+}
+#endif
+#if defined(muSIMD_GenerateDelta4) || !defined(muEnableISPC)
+void GenerateDelta(float3 *dst, const float4 *base, const float4 *target, size_t num)
+{
+    Forward(GenerateDelta, dst, base, target, num);
+}
+#endif
+
+#if defined(muSIMD_MulAddIndexed3) || !defined(muEnableISPC)
+void MulAddIndexed(float3 *dst, const float3 *src, const int *indices, float w, size_t num)
+{
+    Forward(MulAddIndexed, dst, src, indices, w, num);
+}
+#endif
+#if defined(muSIMD_MulAddIndexed4) || !defined(muEnableISPC)
+void MulAddIndexed(float4 *dst, const float3 *src, const int *indices, float w, size_t num)
+{
+    Forward(MulAddIndexed, dst, src, indices, w, num);
+}
+#endif
+
 #if defined(muSIMD_MinMax2) || !defined(muEnableISPC)
 void MinMax(const float2 *p, size_t num, float2& dst_min, float2& dst_max)
 {
@@ -348,18 +511,66 @@ bool NearEqual(const float4 *src1, const float4 *src2, size_t num, float eps)
 }
 #endif
 
+#if defined(muSIMD_NearZero) || !defined(muEnableISPC)
+bool NearZero(const float *src, size_t num, float eps)
+{
+    return Forward(NearZero, src, num, eps);
+}
+bool NearZero(const float3 *src, size_t num, float eps)
+{
+    return NearZero((const float*)src, num * 3, eps);
+}
+#endif
+
 #if defined(muSIMD_MulPoints3) || !defined(muEnableISPC)
 void MulPoints(const float4x4& m, const float3 src[], float3 dst[], size_t num_data)
 {
     Forward(MulPoints, m, src, dst, num_data);
 }
 #endif
+#if defined(muSIMD_Skinning4) || !defined(muEnableISPC)
+void Skinning(const float4x4 poses[], const Weights4 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    Forward(Skinning, poses, weights, ipoints, inormals, itangents, opoints, onormals, otangents, num);
+}
+#endif
+#if defined(muSIMD_Skinning8) || !defined(muEnableISPC)
+void Skinning(const float4x4 poses[], const Weights8 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num)
+{
+    Forward(Skinning, poses, weights, ipoints, inormals, itangents, opoints, onormals, otangents, num);
+}
+#endif
+
 #if defined(muSIMD_MulVectors3) || !defined(muEnableISPC)
 void MulVectors(const float4x4& m, const float3 src[], float3 dst[], size_t num_data)
 {
     Forward(MulVectors, m, src, dst, num_data);
 }
 #endif
+#if defined(muSIMD_ProjectPoints) || !defined(muEnableISPC)
+void ProjectPoints(const float4x4& m, const float3 src[], float dst_x[], float dst_y[], float dst_z[], float dst_w[], size_t num_data)
+{
+    Forward(ProjectPoints, m, src, dst_x, dst_y, dst_z, dst_w, num_data);
+}
+#endif
+#if defined(muSIMD_MulPointsSoA) || !defined(muEnableISPC)
+void MulPointsSoA(const float4x4& m, const float src_x[], const float src_y[], const float src_z[],
+    float dst_x[], float dst_y[], float dst_z[], size_t num_data)
+{
+    Forward(MulPointsSoA, m, src_x, src_y, src_z, dst_x, dst_y, dst_z, num_data);
+}
+#endif
+#if defined(muSIMD_SelectInsideSoA) || !defined(muEnableISPC)
+int SelectInsideSoA(const float4x4& m, const float src_x[], const float src_y[], const float src_z[], const int indices[], size_t num_data,
+    float3 pos, float radius, int dst_indices[], float dst_distances[])
+{
+    return Forward(SelectInsideSoA, m, src_x, src_y, src_z, indices, num_data, pos, radius, dst_indices, dst_distances);
+}
+#endif
 
 #if defined(muSIMD_RayTrianglesIntersectionIndexed) || !defined(muEnableISPC)
 int RayTrianglesIntersectionIndexed(float3 pos, float3 dir, const float3 *vertices, const int *indices, int num_triangles, int& tindex, float& result)
@@ -467,4 +678,51 @@ void GenerateTangentsTriangleSoA(float4 *dst,
 #endif
 
 #undef Forward
+
+
+namespace {
+struct SIMDTargetInfo
+{
+    SIMDTarget target = SIMDTarget::Generic;
+    int width = 1;
+
+    SIMDTargetInfo()
+    {
+#ifdef muEnableISPC
+        // goes through ISPC's dispatcher, so this is the target all other kernels run on
+        target = (SIMDTarget)ispc::GetTarget(width);
+#endif
+    }
+};
+
+const SIMDTargetInfo& GetSIMDTargetInfo()
+{
+    static const SIMDTargetInfo s_info;
+    return s_info;
+}
+} // namespace
+
+SIMDTarget GetSIMDTarget()
+{
+    return GetSIMDTargetInfo().target;
+}
+
+const char* GetSIMDTargetName(SIMDTarget v)
+{
+    switch (v) {
+    case SIMDTarget::SSE2: return "sse2";
+    case SIMDTarget::SSE4: return "sse4";
+    case SIMDTarget::AVX: return "avx";
+    case SIMDTarget::AVX2: return "avx2";
+    case SIMDTarget::AVX512KNL: return "avx512knl";
+    case SIMDTarget::AVX512SKX: return "avx512skx";
+    default: return "generic";
+    }
+}
+
+int GetSIMDWidth()
+{
+    return GetSIMDTargetInfo().width;
+}
+
 } // namespace mu
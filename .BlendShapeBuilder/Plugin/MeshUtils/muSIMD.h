@@ -1,5 +1,6 @@
 #pragma once
 #include "muSIMDConfig.h"
+#include "muVertex.h"
 
 namespace mu {
 
@@ -7,6 +8,13 @@ namespace mu {
 void FloatToHalf(half *dst, const float *src, size_t num);
 void HalfToFloat(float *dst, const half *src, size_t num);
 #endif // muEnableHalf
+// IEEE 754 binary16 conversion that doesn't depend on half of OpenEXR. uint16_t are raw bits of half.
+void FloatToHalfBits(uint16_t *dst, const float *src, size_t num);
+void HalfBitsToFloat(float *dst, const uint16_t *src, size_t num);
+// quantize points into 16 bit unsigned normalized integers per component within bmin - bmax (e.g. result of MinMax()).
+// dst / src of quantized points have num * 3 elements.
+void QuantizePoints(uint16_t *dst, const float3 *src, size_t num, float3 bmin, float3 bmax);
+void DequantizePoints(float3 *dst, const uint16_t *src, size_t num, float3 bmin, float3 bmax);
 
 void InvertX(float3 *dst, size_t num);
 void InvertX(float4 *dst, size_t num);
@@ -17,15 +25,45 @@ void Normalize(float3 *dst, size_t num);
 void Lerp(float *dst, const float *src1, const float *src2, size_t num, float w);
 void Lerp(float2 *dst, const float2 *src1, const float2 *src2, size_t num, float w);
 void Lerp(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float w);
+// dst = target - base
+void GenerateDelta(float *dst, const float *base, const float *target, size_t num);
+void GenerateDelta(float3 *dst, const float3 *base, const float3 *target, size_t num);
+// only xyz of src (e.g. tangents)
+void GenerateDelta(float3 *dst, const float4 *base, const float4 *target, size_t num);
+// dst[indices[i]] += src[i] * w. indices must be unique.
+void MulAddIndexed(float3 *dst, const float3 *src, const int *indices, float w, size_t num);
+// only xyz of dst
+void MulAddIndexed(float4 *dst, const float3 *src, const int *indices, float w, size_t num);
 void MinMax(const float3 *src, size_t num, float3& dst_min, float3& dst_max);
 void MinMax(const float2 *src, size_t num, float2& dst_min, float2& dst_max);
 bool NearEqual(const float *src1, const float *src2, size_t num, float eps = muEpsilon);
 bool NearEqual(const float2 *src1, const float2 *src2, size_t num, float eps = muEpsilon);
 bool NearEqual(const float3 *src1, const float3 *src2, size_t num, float eps = muEpsilon);
 bool NearEqual(const float4 *src1, const float4 *src2, size_t num, float eps = muEpsilon);
+bool NearZero(const float *src, size_t num, float eps = muEpsilon);
+bool NearZero(const float3 *src, size_t num, float eps = muEpsilon);
 
 void MulPoints(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
 void MulVectors(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
+// transform points by m (e.g. model-view-projection) and store the results in SoA.
+// dst_x, dst_y: x and y divided by w. dst_z, dst_w: as is.
+void ProjectPoints(const float4x4& m, const float3 src[], float dst_x[], float dst_y[], float dst_z[], float dst_w[], size_t num_data);
+// SoA version of MulPoints(). dst can be same as src.
+void MulPointsSoA(const float4x4& m, const float src_x[], const float src_y[], const float src_z[],
+    float dst_x[], float dst_y[], float dst_z[], size_t num_data);
+// transform points by m and gather ones within radius from pos. points are src_*[indices[i]], or src_*[i] if indices is null.
+// dst_indices and dst_distances (both must have num_data elements) receive point indices in ascending order of i and
+// the distances. returns the number of points inside.
+int SelectInsideSoA(const float4x4& m, const float src_x[], const float src_y[], const float src_z[], const int indices[], size_t num_data,
+    float3 pos, float radius, int dst_indices[], float dst_distances[]);
+
+// skin points, normals and tangents in one pass. null inputs / outputs are skipped. normals are normalized.
+void Skinning(const float4x4 poses[], const Weights4 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num);
+void Skinning(const float4x4 poses[], const Weights8 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num);
 
 int RayTrianglesIntersectionIndexed(float3 pos, float3 dir, const float3 *vertices, const int *indices, int num_triangles, int& tindex, float& distance);
 int RayTrianglesIntersectionFlattened(float3 pos, float3 dir, const float3 *vertices, int num_triangles, int& tindex, float& distance);
@@ -73,6 +111,24 @@ void GenerateTangentsTriangleSoA(float4 *dst,
     const float3 *normals, const int *indices,
     int num_triangles, int num_vertices);
 
+// instruction set of the ISPC target selected on this CPU. ISPC kernels are compiled for multiple targets
+// (see ISPC_TARGETS in cmake/ISPC.cmake) and dispatched at runtime. Generic if built without ISPC.
+// the value must match the one returned by ispc::GetTarget() (MeshUtilsCore.ispc).
+enum class SIMDTarget
+{
+    Generic,
+    SSE2,
+    SSE4,
+    AVX,
+    AVX2,
+    AVX512KNL,
+    AVX512SKX,
+};
+SIMDTarget GetSIMDTarget();
+const char* GetSIMDTargetName(SIMDTarget v);
+// number of lanes (ISPC's programCount) of the selected target. 1 if Generic.
+int GetSIMDWidth();
+
 
 // ------------------------------------------------------------
 // internal (for test)
@@ -83,6 +139,14 @@ void FloatToHalf_ISPC(half *dst, const float *src, size_t num);
 void HalfToFloat_Generic(float *dst, const half *src, size_t num);
 void HalfToFloat_ISPC(float *dst, const half *src, size_t num);
 #endif // muEnableHalf
+void FloatToHalfBits_Generic(uint16_t *dst, const float *src, size_t num);
+void FloatToHalfBits_ISPC(uint16_t *dst, const float *src, size_t num);
+void HalfBitsToFloat_Generic(float *dst, const uint16_t *src, size_t num);
+void HalfBitsToFloat_ISPC(float *dst, const uint16_t *src, size_t num);
+void QuantizePoints_Generic(uint16_t *dst, const float3 *src, size_t num, float3 bmin, float3 bmax);
+void QuantizePoints_ISPC(uint16_t *dst, const float3 *src, size_t num, float3 bmin, float3 bmax);
+void DequantizePoints_Generic(float3 *dst, const uint16_t *src, size_t num, float3 bmin, float3 bmax);
+void DequantizePoints_ISPC(float3 *dst, const uint16_t *src, size_t num, float3 bmin, float3 bmax);
 
 void InvertX_Generic(float3 *dst, size_t num);
 void InvertX_ISPC(float3 *dst, size_t num);
@@ -100,6 +164,16 @@ void Normalize_ISPC(float3 *dst, size_t num);
 void Lerp_Generic(float *dst, const float *src1, const float *src2, size_t num, float w);
 void Lerp_ISPC(float *dst, const float *src1, const float *src2, size_t num, float w);
 
+void GenerateDelta_Generic(float *dst, const float *base, const float *target, size_t num);
+void GenerateDelta_ISPC(float *dst, const float *base, const float *target, size_t num);
+void GenerateDelta_Generic(float3 *dst, const float4 *base, const float4 *target, size_t num);
+void GenerateDelta_ISPC(float3 *dst, const float4 *base, const float4 *target, size_t num);
+
+void MulAddIndexed_Generic(float3 *dst, const float3 *src, const int *indices, float w, size_t num);
+void MulAddIndexed_ISPC(float3 *dst, const float3 *src, const int *indices, float w, size_t num);
+void MulAddIndexed_Generic(float4 *dst, const float3 *src, const int *indices, float w, size_t num);
+void MulAddIndexed_ISPC(float4 *dst, const float3 *src, const int *indices, float w, size_t num);
+
 void MinMax_Generic(const float2 *src, size_t num, float2& dst_min, float2& dst_max);
 void MinMax_ISPC(const float2 *src, size_t num, float2& dst_min, float2& dst_max);
 void MinMax_Generic(const float3 *src, size_t num, float3& dst_min, float3& dst_max);
@@ -107,11 +181,36 @@ void MinMax_ISPC(const float3 *src, size_t num, float3& dst_min, float3& dst_max
 
 bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float eps);
 bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps);
+bool NearZero_Generic(const float *src, size_t num, float eps);
+bool NearZero_ISPC(const float *src, size_t num, float eps);
 
 void MulPoints_Generic(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
 void MulPoints_ISPC(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
 void MulVectors_Generic(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
 void MulVectors_ISPC(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
+void ProjectPoints_Generic(const float4x4& m, const float3 src[], float dst_x[], float dst_y[], float dst_z[], float dst_w[], size_t num_data);
+void ProjectPoints_ISPC(const float4x4& m, const float3 src[], float dst_x[], float dst_y[], float dst_z[], float dst_w[], size_t num_data);
+void MulPointsSoA_Generic(const float4x4& m, const float src_x[], const float src_y[], const float src_z[],
+    float dst_x[], float dst_y[], float dst_z[], size_t num_data);
+void MulPointsSoA_ISPC(const float4x4& m, const float src_x[], const float src_y[], const float src_z[],
+    float dst_x[], float dst_y[], float dst_z[], size_t num_data);
+int SelectInsideSoA_Generic(const float4x4& m, const float src_x[], const float src_y[], const float src_z[], const int indices[], size_t num_data,
+    float3 pos, float radius, int dst_indices[], float dst_distances[]);
+int SelectInsideSoA_ISPC(const float4x4& m, const float src_x[], const float src_y[], const float src_z[], const int indices[], size_t num_data,
+    float3 pos, float radius, int dst_indices[], float dst_distances[]);
+
+void Skinning_Generic(const float4x4 poses[], const Weights4 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num);
+void Skinning_ISPC(const float4x4 poses[], const Weights4 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num);
+void Skinning_Generic(const float4x4 poses[], const Weights8 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num);
+void Skinning_ISPC(const float4x4 poses[], const Weights8 weights[],
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[], size_t num);
 
 int RayTrianglesIntersectionIndexed_Generic(float3 pos, float3 dir, const float3 *vertices, const int *indices, int num_triangles, int& tindex, float& distance);
 int RayTrianglesIntersectionIndexed_ISPC(float3 pos, float3 dir, const float3 *vertices, const int *indices, int num_triangles, int& tindex, float& distance);
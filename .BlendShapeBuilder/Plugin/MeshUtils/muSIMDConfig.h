@@ -2,19 +2,34 @@
 
 //#define muSIMD_FloatToHalf
 //#define muSIMD_HalfToFloat
+#define muSIMD_FloatToHalfBits
+#define muSIMD_HalfBitsToFloat
+#define muSIMD_QuantizePoints
+#define muSIMD_DequantizePoints
 
 //#define muSIMD_InvertX3
 //#define muSIMD_InvertX4
 //#define muSIMD_Scale
 #define muSIMD_Normalize
 //#define muSIMD_Lerp
+#define muSIMD_GenerateDelta
+#define muSIMD_GenerateDelta4
+#define muSIMD_MulAddIndexed3
+#define muSIMD_MulAddIndexed4
 #define muSIMD_NearEqual
+#define muSIMD_NearZero
 
 #define muSIMD_MinMax2
 //#define muSIMD_MinMax3
 
 //#define muSIMD_MulVectors3
 //#define muSIMD_MulPoints3
+#define muSIMD_ProjectPoints
+#define muSIMD_MulPointsSoA
+#define muSIMD_SelectInsideSoA
+
+#define muSIMD_Skinning4
+#define muSIMD_Skinning8
 
 #define muSIMD_RayTrianglesIntersectionIndexed
 //#define muSIMD_RayTrianglesIntersectionFlattened
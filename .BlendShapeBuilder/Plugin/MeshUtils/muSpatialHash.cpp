@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "MeshUtils.h"
+
+namespace mu {
+
+void SpatialHashGrid::clear()
+{
+    m_cell_size = m_rcp_cell_size = 0.0f;
+    m_bucket_mask = 0;
+    m_buckets.clear();
+    m_cells.clear();
+    m_slots.clear();
+}
+
+void SpatialHashGrid::build(const float3 *points, int num_points, float cell_size)
+{
+    clear();
+    if (num_points <= 0) { return; }
+
+    if (cell_size <= 0.0f) {
+        // assume points are on surfaces and aim a few points per cell
+        float3 bmin, bmax;
+        MinMax(points, num_points, bmin, bmax);
+        float3 e = bmax - bmin;
+        float area = (e.x * e.y + e.y * e.z + e.z * e.x) * 2.0f;
+        cell_size = std::sqrt(area / num_points) * 2.0f;
+        if (!(cell_size > 0.0f)) {
+            cell_size = std::max<float>(std::max<float>(std::max<float>(e.x, e.y), e.z), 1.0f);
+        }
+    }
+    m_cell_size = cell_size;
+    m_rcp_cell_size = 1.0f / cell_size;
+
+    int num_buckets = 64;
+    while (num_buckets < num_points) { num_buckets *= 2; }
+    m_bucket_mask = num_buckets - 1;
+    m_buckets.resize(num_buckets);
+
+    m_cells.resize_discard(num_points);
+    m_slots.resize_discard(num_points);
+    parallel_for_blocked(0, num_points, 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            m_cells[i] = toCell(points[i]);
+        }
+    });
+    for (int i = 0; i < num_points; ++i) {
+        insert(i, m_cells[i]);
+    }
+}
+
+void SpatialHashGrid::update(int index, const float3& pos)
+{
+    Cell c = toCell(pos);
+    if (c != m_cells[index]) {
+        erase(index);
+        m_cells[index] = c;
+        insert(index, c);
+    }
+}
+
+void SpatialHashGrid::update(const float3 *points)
+{
+    int num_points = (int)m_cells.size();
+
+    // cells are computed in parallel. only relocation is serial.
+    RawVector<Cell> cells;
+    cells.resize_discard(num_points);
+    parallel_for_blocked(0, num_points, 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            cells[i] = toCell(points[i]);
+        }
+    });
+    for (int i = 0; i < num_points; ++i) {
+        if (cells[i] != m_cells[i]) {
+            erase(i);
+            m_cells[i] = cells[i];
+            insert(i, cells[i]);
+        }
+    }
+}
+
+void SpatialHashGrid::update(const float3 *points, const uint32_t *bits)
+{
+    int num_points = (int)m_cells.size();
+    int num_words = ceildiv(num_points, 32);
+    for (int wi = 0; wi < num_words; ++wi) {
+        uint32_t word = bits[wi];
+        for (int bi = 0; word != 0; ++bi, word >>= 1) {
+            if (word & 1) {
+                update(wi * 32 + bi, points[wi * 32 + bi]);
+            }
+        }
+    }
+}
+
+SpatialHashGrid::Cell SpatialHashGrid::toCell(const float3& p) const
+{
+    // clamp to avoid overflow of int
+    const float lim = 1e9f;
+    return {
+        (int)std::floor(clamp(p.x * m_rcp_cell_size, -lim, lim)),
+        (int)std::floor(clamp(p.y * m_rcp_cell_size, -lim, lim)),
+        (int)std::floor(clamp(p.z * m_rcp_cell_size, -lim, lim)),
+    };
+}
+
+int SpatialHashGrid::toBucket(const Cell& c) const
+{
+    uint32_t h =
+        ((uint32_t)c.x * 73856093u) ^
+        ((uint32_t)c.y * 19349663u) ^
+        ((uint32_t)c.z * 83492791u);
+    return (int)(h & (uint32_t)m_bucket_mask);
+}
+
+void SpatialHashGrid::insert(int index, const Cell& c)
+{
+    auto& bucket = m_buckets[toBucket(c)];
+    m_slots[index] = (int)bucket.size();
+    bucket.push_back(index);
+}
+
+void SpatialHashGrid::erase(int index)
+{
+    auto& bucket = m_buckets[toBucket(m_cells[index])];
+    int slot = m_slots[index];
+    int last = bucket.back();
+    bucket[slot] = last;
+    m_slots[last] = slot;
+    bucket.pop_back();
+}
+
+
+
+void PointGrid2D::clear()
+{
+    m_bmin = m_rcp_cell_size = float2::zero();
+    m_div_x = m_div_y = 0;
+    m_offsets.clear();
+    m_indices.clear();
+}
+
+void PointGrid2D::build(const float *xs, const float *ys, int num_points, float2 bmin, float2 bmax, int num_cells)
+{
+    clear();
+    if (num_points <= 0 || !(bmin.x < bmax.x && bmin.y < bmax.y)) { return; }
+
+    if (num_cells <= 0) {
+        // aim a few points per cell
+        num_cells = num_points / 8;
+    }
+    int div = std::min<int>(std::max<int>((int)std::sqrt((float)num_cells), 1), 256);
+    m_div_x = m_div_y = div;
+    m_bmin = bmin;
+    m_rcp_cell_size = float2{ div / (bmax.x - bmin.x), div / (bmax.y - bmin.y) };
+
+    // counting sort by cell
+    RawVector<int> cells;
+    cells.resize_discard(num_points);
+    parallel_for_blocked(0, num_points, 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            float x = xs[i], y = ys[i];
+            cells[i] = (x == x && y == y) ? toCellY(y) * m_div_x + toCellX(x) : -1;
+        }
+    });
+
+    int total_cells = m_div_x * m_div_y;
+    m_offsets.resize(total_cells + 1);
+    m_offsets.zeroclear();
+    int num_valid = 0;
+    for (int i = 0; i < num_points; ++i) {
+        int c = cells[i];
+        if (c >= 0) {
+            ++m_offsets[c + 1];
+            ++num_valid;
+        }
+    }
+    for (int c = 0; c < total_cells; ++c) {
+        m_offsets[c + 1] += m_offsets[c];
+    }
+
+    RawVector<int> pos;
+    pos.assign(m_offsets.begin(), m_offsets.end() - 1);
+    m_indices.resize_discard(num_valid);
+    for (int i = 0; i < num_points; ++i) {
+        int c = cells[i];
+        if (c >= 0) {
+            m_indices[pos[c]++] = i;
+        }
+    }
+}
+
+void PointGrid2D::gatherPointsInRect(float2 rmin, float2 rmax, RawVector<int>& dst) const
+{
+    dst.clear();
+    eachPointsInRect(rmin, rmax, [&](int i) { dst.push_back(i); });
+}
+
+int PointGrid2D::toCellX(float x) const
+{
+    // clamp in float to avoid overflow of int
+    return (int)clamp((x - m_bmin.x) * m_rcp_cell_size.x, 0.0f, float(m_div_x - 1));
+}
+
+int PointGrid2D::toCellY(float y) const
+{
+    return (int)clamp((y - m_bmin.y) * m_rcp_cell_size.y, 0.0f, float(m_div_y - 1));
+}
+
+} // namespace mu
@@ -0,0 +1,145 @@
+#pragma once
+
+namespace mu {
+
+// uniform grid of points. cells are hashed into fixed number of buckets, so memory usage depends
+// only on the number of points. points can be moved incrementally by update().
+class SpatialHashGrid
+{
+public:
+    void clear();
+    // cell_size <= 0: estimate from bounds and number of points
+    void build(const float3 *points, int num_points, float cell_size = 0.0f);
+    // points[index] has been moved to pos
+    void update(int index, const float3& pos);
+    // points may have been moved. only points that crossed cells are relocated.
+    void update(const float3 *points);
+    // same as above, but only points marked in bits (bit i % 32 of word i / 32) are examined.
+    // the other points must be unchanged since the last build / update.
+    void update(const float3 *points, const uint32_t *bits);
+
+    bool empty() const { return m_cells.empty(); }
+    int getNumPoints() const { return (int)m_cells.size(); }
+    float getCellSize() const { return m_cell_size; }
+
+    // Body: [](int point_index) -> void
+    // enumerate points in the cells overlapping [bmin, bmax]. points outside the box can be included.
+    template<class Body>
+    void eachPointsInBox(const float3& bmin, const float3& bmax, const Body& body) const;
+
+    // Body: [](int point_index) -> void
+    // enumerate points in the cells overlapping the sphere. points outside the sphere can be included.
+    template<class Body>
+    void eachPointsInSphere(const float3& pos, float radius, const Body& body) const
+    {
+        float3 r = { radius, radius, radius };
+        eachPointsInBox(pos - r, pos + r, body);
+    }
+
+private:
+    struct Cell
+    {
+        int x, y, z;
+        bool operator==(const Cell& v) const { return x == v.x && y == v.y && z == v.z; }
+        bool operator!=(const Cell& v) const { return !(*this == v); }
+    };
+    Cell toCell(const float3& p) const;
+    int toBucket(const Cell& c) const;
+    void insert(int index, const Cell& c);
+    void erase(int index);
+
+    float m_cell_size = 0.0f;
+    float m_rcp_cell_size = 0.0f;
+    int m_bucket_mask = 0;
+    std::vector<RawVector<int>> m_buckets;
+    RawVector<Cell> m_cells; // cell of each point
+    RawVector<int> m_slots; // position of each point in its bucket
+};
+
+
+// uniform 2D grid of points over a fixed rectangle (e.g. screen space) in CSR form.
+// points outside the rectangle are stored in the border cells. NaN points are not stored.
+class PointGrid2D
+{
+public:
+    void clear();
+    // num_cells <= 0: estimate from the number of points
+    void build(const float *xs, const float *ys, int num_points, float2 bmin, float2 bmax, int num_cells = 0);
+
+    bool empty() const { return m_indices.empty(); }
+
+    // Body: [](int point_index) -> void
+    // enumerate points in the cells overlapping [rmin, rmax]. points outside the rectangle can be included.
+    template<class Body>
+    void eachPointsInRect(float2 rmin, float2 rmax, const Body& body) const
+    {
+        if (empty() || !(rmin.x <= rmax.x && rmin.y <= rmax.y)) { return; }
+        int x1 = toCellX(rmin.x), x2 = toCellX(rmax.x);
+        int y1 = toCellY(rmin.y), y2 = toCellY(rmax.y);
+        for (int y = y1; y <= y2; ++y) {
+            // cells in a row are contiguous
+            int begin = m_offsets[y * m_div_x + x1];
+            int end = m_offsets[y * m_div_x + x2 + 1];
+            for (int i = begin; i < end; ++i) {
+                body(m_indices[i]);
+            }
+        }
+    }
+    // gather indices of points in the cells overlapping [rmin, rmax]
+    void gatherPointsInRect(float2 rmin, float2 rmax, RawVector<int>& dst) const;
+
+private:
+    int toCellX(float x) const;
+    int toCellY(float y) const;
+
+    float2 m_bmin = float2::zero();
+    float2 m_rcp_cell_size = float2::zero();
+    int m_div_x = 0, m_div_y = 0;
+    RawVector<int> m_offsets; // num_cells + 1
+    RawVector<int> m_indices; // point indices sorted by cell
+};
+
+
+template<class Body>
+inline void SpatialHashGrid::eachPointsInBox(const float3& bmin, const float3& bmax, const Body& body) const
+{
+    if (empty()) { return; }
+
+    Cell cmin = toCell(bmin);
+    Cell cmax = toCell(bmax);
+    double num_cells =
+        double(cmax.x - cmin.x + 1) *
+        double(cmax.y - cmin.y + 1) *
+        double(cmax.z - cmin.z + 1);
+
+    if (num_cells > (double)m_cells.size()) {
+        // the box is too large compared to the number of points. just test all points.
+        int num_points = (int)m_cells.size();
+        for (int i = 0; i < num_points; ++i) {
+            const auto& c = m_cells[i];
+            if (c.x >= cmin.x && c.x <= cmax.x &&
+                c.y >= cmin.y && c.y <= cmax.y &&
+                c.z >= cmin.z && c.z <= cmax.z)
+            {
+                body(i);
+            }
+        }
+        return;
+    }
+
+    Cell c;
+    for (c.z = cmin.z; c.z <= cmax.z; ++c.z) {
+        for (c.y = cmin.y; c.y <= cmax.y; ++c.y) {
+            for (c.x = cmin.x; c.x <= cmax.x; ++c.x) {
+                // buckets can be shared by multiple cells
+                for (int i : m_buckets[toBucket(c)]) {
+                    if (m_cells[i] == c) {
+                        body(i);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace mu
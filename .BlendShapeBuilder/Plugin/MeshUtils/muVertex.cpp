@@ -105,4 +105,13 @@ void Interleave(void *dst, VertexFormat format, size_t num,
     }
 }
 
+void Deinterleave(float *dst_x, float *dst_y, float *dst_z, const float3 *src, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst_x[i] = src[i].x;
+        dst_y[i] = src[i].y;
+        dst_z[i] = src[i].z;
+    }
+}
+
 } // namespace mu
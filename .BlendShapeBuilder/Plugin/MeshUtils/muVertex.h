@@ -160,6 +160,9 @@ void Interleave(void *dst, VertexFormat format, size_t num,
     const float4 *tangents
 );
 
+// split float3 array into x, y and z arrays (SoA)
+void Deinterleave(float *dst_x, float *dst_y, float *dst_z, const float3 *src, size_t num);
+
 template<class VertexT> void Interleave_Generic(VertexT *dst, const typename VertexT::source_t& src, size_t num);
 
 } // namespace mu
@@ -0,0 +1,648 @@
+// measures _Generic / _ISPC pairs in muSIMD.h and some of VertexTweaker's entry points.
+// usage: MeshUtilsBench [max_size] [min_time_ms]
+// results are written to stdout as CSV. one line per (benchmark, impl, size).
+// _ISPC variants are measured only if the library is built with ISPC and the corresponding muSIMD_* is enabled.
+// the first line is a comment with the ISPC target selected at runtime (e.g. "# simd_target,avx2,8").
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include "VertexTweaker/VertexTweaker.h"
+
+// exported by VertexTweaker.cpp and npMeshContext.cpp
+extern "C" {
+void npGenerateTerrainMesh(
+    const float heightmap[], int width, int height, float3 size,
+    float3 dst_vertices[], float3 dst_normals[], float2 dst_uv[], int dst_indices[]);
+int npGetTerrainChunkSize(
+    int width, int height, int tile_size, int lod, int tx, int ty, int *num_vertices, int *num_triangles);
+int npGenerateTerrainChunk(
+    const float heightmap[], int width, int height, float3 size, int tile_size, int lod, int tx, int ty,
+    float3 dst_vertices[], float3 dst_normals[], float2 dst_uv[], int dst_indices[]);
+int npSelectRect(
+    npMeshData *model,
+    const float4x4 *mvp_, float2 rmin, float2 rmax, float3 campos, float strength, int frontface_only);
+void npGenerateTangents(npMeshData *model, float4 dst[], npTangentsMode mode);
+void npProjectVertices(
+    npMeshData *model, npMeshData *target, const float3 ray_dirs[], npProjectVerticesMode mode, float max_distance, int PNT, int mask);
+void npApplySkinning(
+    npSkinData *skin,
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[]);
+npMeshContext* npCreateMeshContext();
+void npReleaseMeshContext(npMeshContext *ctx);
+const char* npGetSIMDTarget(int *width);
+}
+
+
+static nanosec g_min_time = 200 * 1000000; // per measurement
+
+static void PrintHeader()
+{
+    int width = 1;
+    const char *target = npGetSIMDTarget(&width);
+    printf("# simd_target,%s,%d\n", target, width);
+    printf("benchmark,impl,size,iterations,avg_ns,min_ns,ns_per_element\n");
+}
+
+// runs body repeatedly for at least g_min_time (and at least 3 times) and prints the result.
+// size is the number of elements processed by one call of body.
+template<class Body>
+static void Bench(const char *name, const char *impl, int size, const Body& body)
+{
+    body(); // warm up
+
+    int iterations = 0;
+    nanosec total = 0, min_time = ~0ull;
+    while (total < g_min_time || iterations < 3) {
+        nanosec begin = Now();
+        body();
+        nanosec elapsed = Now() - begin;
+        total += elapsed;
+        min_time = std::min(min_time, elapsed);
+        ++iterations;
+    }
+    nanosec avg = total / iterations;
+    printf("%s,%s,%d,%d,%llu,%llu,%.3f\n", name, impl, size, iterations,
+        (unsigned long long)avg, (unsigned long long)min_time, (double)min_time / size);
+    fflush(stdout);
+}
+
+// keeps results alive so that the compiler doesn't eliminate the work
+static volatile float g_sink;
+
+
+struct TestMesh
+{
+    int width = 0, height = 0;
+    float3 size = { 10.0f, 1.0f, 10.0f };
+    RawVector<float> heightmap;
+    RawVector<float3> points;
+    RawVector<float3> normals;
+    RawVector<float4> tangents;
+    RawVector<float2> uv;
+    RawVector<int> indices;
+    int num_vertices = 0;
+    int num_triangles = 0;
+
+    // flattened & SoA-nized triangles
+    RawVector<float3> points_flattened;
+    RawVector<float2> uv_flattened;
+    RawVector<float> soa[9];
+    RawVector<float> uv_soa[6];
+
+    // approximately num_vertices vertices
+    void build(int num_vertices_)
+    {
+        width = height = std::max<int>((int)std::sqrt((float)num_vertices_), 2);
+        num_vertices = width * height;
+        num_triangles = (width - 1) * (height - 1) * 2;
+
+        heightmap.resize_discard(num_vertices);
+        for (int iy = 0; iy < height; ++iy) {
+            for (int ix = 0; ix < width; ++ix) {
+                heightmap[iy * width + ix] = std::sin(ix * 0.05f) * std::cos(iy * 0.07f) * 0.5f + 0.5f;
+            }
+        }
+
+        points.resize_discard(num_vertices);
+        normals.resize_discard(num_vertices);
+        uv.resize_discard(num_vertices);
+        indices.resize_discard(num_triangles * 3);
+        npGenerateTerrainMesh(heightmap.data(), width, height, size, points.data(), normals.data(), uv.data(), indices.data());
+
+        tangents.resize_discard(num_vertices);
+        GenerateTangentsTriangleIndexed(tangents.data(), points.data(), uv.data(), normals.data(), indices.data(), num_triangles, num_vertices);
+
+        int num_indices = num_triangles * 3;
+        points_flattened.resize_discard(num_indices);
+        uv_flattened.resize_discard(num_indices);
+        CopyWithIndices(points_flattened.data(), points.data(), indices);
+        CopyWithIndices(uv_flattened.data(), uv.data(), indices);
+        for (auto& a : soa) { a.resize_discard(num_triangles); }
+        for (auto& a : uv_soa) { a.resize_discard(num_triangles); }
+        for (int ti = 0; ti < num_triangles; ++ti) {
+            for (int ci = 0; ci < 3; ++ci) {
+                float3 p = points_flattened[ti * 3 + ci];
+                float2 u = uv_flattened[ti * 3 + ci];
+                soa[ci * 3 + 0][ti] = p.x;
+                soa[ci * 3 + 1][ti] = p.y;
+                soa[ci * 3 + 2][ti] = p.z;
+                uv_soa[ci * 2 + 0][ti] = u.x;
+                uv_soa[ci * 2 + 1][ti] = u.y;
+            }
+        }
+    }
+
+    // maps xz of the terrain to xy of normalized device coordinates
+    float4x4 getMVP() const
+    {
+        return float4x4{ {
+            { 2.0f / size.x, 0.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f, 0.0f },
+            { 0.0f, 2.0f / size.z, 0.0f, 0.0f },
+            { -1.0f, -1.0f, 0.0f, 1.0f },
+        } };
+    }
+};
+
+
+static void BenchVertexKernels(const TestMesh& mesh)
+{
+    int n = mesh.num_vertices;
+    auto m = mesh.getMVP();
+    RawVector<float3> dst3;
+    RawVector<float> a, b, dst1, x, y, z, w;
+    dst3.resize_discard(n);
+    a.resize_discard(n);
+    b.resize_discard(n);
+    dst1.resize_discard(n);
+    x.resize_discard(n); y.resize_discard(n); z.resize_discard(n); w.resize_discard(n);
+    for (int i = 0; i < n; ++i) {
+        a[i] = mesh.points[i].x;
+        b[i] = mesh.points[i].z;
+    }
+
+    Bench("Normalize", "Generic", n, [&]() {
+        dst3 = mesh.points;
+        Normalize_Generic(dst3.data(), n);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_Normalize)
+    Bench("Normalize", "ISPC", n, [&]() {
+        dst3 = mesh.points;
+        Normalize_ISPC(dst3.data(), n);
+    });
+#endif
+
+    Bench("Lerp", "Generic", n, [&]() { Lerp_Generic(dst1.data(), a.data(), b.data(), n, 0.5f); });
+#if defined(muEnableISPC) && defined(muSIMD_Lerp)
+    Bench("Lerp", "ISPC", n, [&]() { Lerp_ISPC(dst1.data(), a.data(), b.data(), n, 0.5f); });
+#endif
+
+    Bench("NearEqual", "Generic", n, [&]() { g_sink = (float)NearEqual_Generic(a.data(), a.data(), n, 0.01f); });
+#if defined(muEnableISPC) && defined(muSIMD_NearEqual)
+    Bench("NearEqual", "ISPC", n, [&]() { g_sink = (float)NearEqual_ISPC(a.data(), a.data(), n, 0.01f); });
+#endif
+
+    float2 bmin2, bmax2;
+    float3 bmin3, bmax3;
+    Bench("MinMax2", "Generic", n, [&]() { MinMax_Generic(mesh.uv.data(), n, bmin2, bmax2); g_sink = bmin2.x; });
+#if defined(muEnableISPC) && defined(muSIMD_MinMax2)
+    Bench("MinMax2", "ISPC", n, [&]() { MinMax_ISPC(mesh.uv.data(), n, bmin2, bmax2); g_sink = bmin2.x; });
+#endif
+    Bench("MinMax3", "Generic", n, [&]() { MinMax_Generic(mesh.points.data(), n, bmin3, bmax3); g_sink = bmin3.x; });
+#if defined(muEnableISPC) && defined(muSIMD_MinMax3)
+    Bench("MinMax3", "ISPC", n, [&]() { MinMax_ISPC(mesh.points.data(), n, bmin3, bmax3); g_sink = bmin3.x; });
+#endif
+
+    RawVector<uint16_t> packed;
+    packed.resize_discard(n * 3);
+    Bench("FloatToHalfBits", "Generic", n, [&]() { FloatToHalfBits_Generic(packed.data(), (const float*)mesh.normals.data(), n * 3); });
+#if defined(muEnableISPC) && defined(muSIMD_FloatToHalfBits)
+    Bench("FloatToHalfBits", "ISPC", n, [&]() { FloatToHalfBits_ISPC(packed.data(), (const float*)mesh.normals.data(), n * 3); });
+#endif
+    Bench("HalfBitsToFloat", "Generic", n, [&]() { HalfBitsToFloat_Generic((float*)dst3.data(), packed.data(), n * 3); });
+#if defined(muEnableISPC) && defined(muSIMD_HalfBitsToFloat)
+    Bench("HalfBitsToFloat", "ISPC", n, [&]() { HalfBitsToFloat_ISPC((float*)dst3.data(), packed.data(), n * 3); });
+#endif
+    Bench("QuantizePoints", "Generic", n, [&]() { QuantizePoints_Generic(packed.data(), mesh.points.data(), n, bmin3, bmax3); });
+#if defined(muEnableISPC) && defined(muSIMD_QuantizePoints)
+    Bench("QuantizePoints", "ISPC", n, [&]() { QuantizePoints_ISPC(packed.data(), mesh.points.data(), n, bmin3, bmax3); });
+#endif
+    Bench("DequantizePoints", "Generic", n, [&]() { DequantizePoints_Generic(dst3.data(), packed.data(), n, bmin3, bmax3); });
+#if defined(muEnableISPC) && defined(muSIMD_DequantizePoints)
+    Bench("DequantizePoints", "ISPC", n, [&]() { DequantizePoints_ISPC(dst3.data(), packed.data(), n, bmin3, bmax3); });
+#endif
+
+    Bench("MulPoints", "Generic", n, [&]() { MulPoints_Generic(m, mesh.points.data(), dst3.data(), n); });
+#if defined(muEnableISPC) && defined(muSIMD_MulPoints3)
+    Bench("MulPoints", "ISPC", n, [&]() { MulPoints_ISPC(m, mesh.points.data(), dst3.data(), n); });
+#endif
+    Bench("MulVectors", "Generic", n, [&]() { MulVectors_Generic(m, mesh.normals.data(), dst3.data(), n); });
+#if defined(muEnableISPC) && defined(muSIMD_MulVectors3)
+    Bench("MulVectors", "ISPC", n, [&]() { MulVectors_ISPC(m, mesh.normals.data(), dst3.data(), n); });
+#endif
+    Bench("ProjectPoints", "Generic", n, [&]() {
+        ProjectPoints_Generic(m, mesh.points.data(), x.data(), y.data(), z.data(), w.data(), n);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_ProjectPoints)
+    Bench("ProjectPoints", "ISPC", n, [&]() {
+        ProjectPoints_ISPC(m, mesh.points.data(), x.data(), y.data(), z.data(), w.data(), n);
+    });
+#endif
+
+    // SoA kernels take SoA form of points
+    RawVector<float> sx, sy, sz;
+    sx.resize_discard(n); sy.resize_discard(n); sz.resize_discard(n);
+    Deinterleave(sx.data(), sy.data(), sz.data(), mesh.points.data(), n);
+    Bench("MulPointsSoA", "Generic", n, [&]() {
+        MulPointsSoA_Generic(m, sx.data(), sy.data(), sz.data(), x.data(), y.data(), z.data(), n);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_MulPointsSoA)
+    Bench("MulPointsSoA", "ISPC", n, [&]() {
+        MulPointsSoA_ISPC(m, sx.data(), sy.data(), sz.data(), x.data(), y.data(), z.data(), n);
+    });
+#endif
+
+    RawVector<int> hits;
+    hits.resize_discard(n);
+    float3 center = (bmin3 + bmax3) * 0.5f;
+    float radius = length(bmax3 - bmin3) * 0.25f;
+    auto model = float4x4::identity();
+    Bench("SelectInsideSoA", "Generic", n, [&]() {
+        SelectInsideSoA_Generic(model, sx.data(), sy.data(), sz.data(), nullptr, n, center, radius, hits.data(), dst1.data());
+    });
+#if defined(muEnableISPC) && defined(muSIMD_SelectInsideSoA)
+    Bench("SelectInsideSoA", "ISPC", n, [&]() {
+        SelectInsideSoA_ISPC(model, sx.data(), sy.data(), sz.data(), nullptr, n, center, radius, hits.data(), dst1.data());
+    });
+#endif
+}
+
+static void BenchSkinningKernels(const TestMesh& mesh)
+{
+    const int num_bones = 16;
+    int n = mesh.num_vertices;
+
+    float4x4 poses[num_bones];
+    for (int bi = 0; bi < num_bones; ++bi) {
+        poses[bi] = to_mat4x4(rotateY(bi * 0.1f));
+        poses[bi][3] = { bi * 0.1f, 0.0f, 0.0f, 1.0f };
+    }
+    RawVector<Weights4> weights4;
+    RawVector<Weights8> weights8;
+    weights4.resize_discard(n);
+    weights8.resize_discard(n);
+    for (int vi = 0; vi < n; ++vi) {
+        for (int i = 0; i < 4; ++i) {
+            weights4[vi].indices[i] = (vi + i) % num_bones;
+            weights4[vi].weights[i] = 0.25f;
+        }
+        for (int i = 0; i < 8; ++i) {
+            weights8[vi].indices[i] = (vi + i) % num_bones;
+            weights8[vi].weights[i] = 0.125f;
+        }
+    }
+
+    RawVector<float3> opoints, onormals;
+    RawVector<float4> otangents;
+    opoints.resize_discard(n);
+    onormals.resize_discard(n);
+    otangents.resize_discard(n);
+
+    Bench("Skinning4", "Generic", n, [&]() {
+        Skinning_Generic(poses, weights4.data(), mesh.points.data(), mesh.normals.data(), mesh.tangents.data(),
+            opoints.data(), onormals.data(), otangents.data(), n);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_Skinning4)
+    Bench("Skinning4", "ISPC", n, [&]() {
+        Skinning_ISPC(poses, weights4.data(), mesh.points.data(), mesh.normals.data(), mesh.tangents.data(),
+            opoints.data(), onormals.data(), otangents.data(), n);
+    });
+#endif
+    Bench("Skinning8", "Generic", n, [&]() {
+        Skinning_Generic(poses, weights8.data(), mesh.points.data(), mesh.normals.data(), mesh.tangents.data(),
+            opoints.data(), onormals.data(), otangents.data(), n);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_Skinning8)
+    Bench("Skinning8", "ISPC", n, [&]() {
+        Skinning_ISPC(poses, weights8.data(), mesh.points.data(), mesh.normals.data(), mesh.tangents.data(),
+            opoints.data(), onormals.data(), otangents.data(), n);
+    });
+#endif
+}
+
+static void BenchTriangleKernels(const TestMesh& mesh)
+{
+    int nt = mesh.num_triangles;
+    int nv = mesh.num_vertices;
+    auto& soa = mesh.soa;
+    auto& usoa = mesh.uv_soa;
+
+    // one ray toward the center of the terrain against all triangles
+    float3 rpos = { mesh.size.x * 0.5f, 10.0f, mesh.size.z * 0.5f };
+    float3 rdir = { 0.0f, -1.0f, 0.0f };
+    int ti;
+    float distance;
+
+    Bench("RayTrianglesIntersectionIndexed", "Generic", nt, [&]() {
+        g_sink = (float)RayTrianglesIntersectionIndexed_Generic(rpos, rdir, mesh.points.data(), mesh.indices.data(), nt, ti, distance);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_RayTrianglesIntersectionIndexed)
+    Bench("RayTrianglesIntersectionIndexed", "ISPC", nt, [&]() {
+        g_sink = (float)RayTrianglesIntersectionIndexed_ISPC(rpos, rdir, mesh.points.data(), mesh.indices.data(), nt, ti, distance);
+    });
+#endif
+    Bench("RayTrianglesIntersectionFlattened", "Generic", nt, [&]() {
+        g_sink = (float)RayTrianglesIntersectionFlattened_Generic(rpos, rdir, mesh.points_flattened.data(), nt, ti, distance);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_RayTrianglesIntersectionFlattened)
+    Bench("RayTrianglesIntersectionFlattened", "ISPC", nt, [&]() {
+        g_sink = (float)RayTrianglesIntersectionFlattened_ISPC(rpos, rdir, mesh.points_flattened.data(), nt, ti, distance);
+    });
+#endif
+    Bench("RayTrianglesIntersectionSoA", "Generic", nt, [&]() {
+        g_sink = (float)RayTrianglesIntersectionSoA_Generic(rpos, rdir,
+            soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(),
+            soa[6].data(), soa[7].data(), soa[8].data(),
+            nt, ti, distance);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_RayTrianglesIntersectionSoA)
+    Bench("RayTrianglesIntersectionSoA", "ISPC", nt, [&]() {
+        g_sink = (float)RayTrianglesIntersectionSoA_ISPC(rpos, rdir,
+            soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(),
+            soa[6].data(), soa[7].data(), soa[8].data(),
+            nt, ti, distance);
+    });
+#endif
+
+    RawVector<float3> normals;
+    RawVector<float4> tangents;
+    normals.resize_discard(nv);
+    tangents.resize_discard(nv);
+
+    Bench("GenerateNormalsTriangleIndexed", "Generic", nt, [&]() {
+        GenerateNormalsTriangleIndexed_Generic(normals.data(), mesh.points.data(), mesh.indices.data(), nt, nv);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_GenerateNormalsTriangleIndexed)
+    Bench("GenerateNormalsTriangleIndexed", "ISPC", nt, [&]() {
+        GenerateNormalsTriangleIndexed_ISPC(normals.data(), mesh.points.data(), mesh.indices.data(), nt, nv);
+    });
+#endif
+    Bench("GenerateNormalsTriangleFlattened", "Generic", nt, [&]() {
+        GenerateNormalsTriangleFlattened_Generic(normals.data(), mesh.points_flattened.data(), mesh.indices.data(), nt, nv);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_GenerateNormalsTriangleFlattened)
+    Bench("GenerateNormalsTriangleFlattened", "ISPC", nt, [&]() {
+        GenerateNormalsTriangleFlattened_ISPC(normals.data(), mesh.points_flattened.data(), mesh.indices.data(), nt, nv);
+    });
+#endif
+    Bench("GenerateNormalsTriangleSoA", "Generic", nt, [&]() {
+        GenerateNormalsTriangleSoA_Generic(normals.data(),
+            soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(),
+            soa[6].data(), soa[7].data(), soa[8].data(),
+            mesh.indices.data(), nt, nv);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_GenerateNormalsTriangleSoA)
+    Bench("GenerateNormalsTriangleSoA", "ISPC", nt, [&]() {
+        GenerateNormalsTriangleSoA_ISPC(normals.data(),
+            soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(),
+            soa[6].data(), soa[7].data(), soa[8].data(),
+            mesh.indices.data(), nt, nv);
+    });
+#endif
+
+    Bench("GenerateTangentsTriangleIndexed", "Generic", nt, [&]() {
+        GenerateTangentsTriangleIndexed_Generic(tangents.data(),
+            mesh.points.data(), mesh.uv.data(), mesh.normals.data(), mesh.indices.data(), nt, nv);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_GenerateTangentsTriangleIndexed)
+    Bench("GenerateTangentsTriangleIndexed", "ISPC", nt, [&]() {
+        GenerateTangentsTriangleIndexed_ISPC(tangents.data(),
+            mesh.points.data(), mesh.uv.data(), mesh.normals.data(), mesh.indices.data(), nt, nv);
+    });
+#endif
+    Bench("GenerateTangentsTriangleFlattened", "Generic", nt, [&]() {
+        GenerateTangentsTriangleFlattened_Generic(tangents.data(),
+            mesh.points_flattened.data(), mesh.uv_flattened.data(), mesh.normals.data(), mesh.indices.data(), nt, nv);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_GenerateTangentsTriangleFlattened)
+    Bench("GenerateTangentsTriangleFlattened", "ISPC", nt, [&]() {
+        GenerateTangentsTriangleFlattened_ISPC(tangents.data(),
+            mesh.points_flattened.data(), mesh.uv_flattened.data(), mesh.normals.data(), mesh.indices.data(), nt, nv);
+    });
+#endif
+    Bench("GenerateTangentsTriangleSoA", "Generic", nt, [&]() {
+        GenerateTangentsTriangleSoA_Generic(tangents.data(),
+            soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(),
+            soa[6].data(), soa[7].data(), soa[8].data(),
+            usoa[0].data(), usoa[1].data(), usoa[2].data(), usoa[3].data(), usoa[4].data(), usoa[5].data(),
+            mesh.normals.data(), mesh.indices.data(), nt, nv);
+    });
+#if defined(muEnableISPC) && defined(muSIMD_GenerateTangentsTriangleSoA)
+    Bench("GenerateTangentsTriangleSoA", "ISPC", nt, [&]() {
+        GenerateTangentsTriangleSoA_ISPC(tangents.data(),
+            soa[0].data(), soa[1].data(), soa[2].data(),
+            soa[3].data(), soa[4].data(), soa[5].data(),
+            soa[6].data(), soa[7].data(), soa[8].data(),
+            usoa[0].data(), usoa[1].data(), usoa[2].data(), usoa[3].data(), usoa[4].data(), usoa[5].data(),
+            mesh.normals.data(), mesh.indices.data(), nt, nv);
+    });
+#endif
+}
+
+static void BenchPolyInside(const TestMesh& mesh)
+{
+    // lasso of 32 points around the center of the screen, against all screen positions of the terrain
+    const int ngon = 32;
+    float2 poly[ngon];
+    float px[ngon], py[ngon];
+    for (int i = 0; i < ngon; ++i) {
+        float a = (float)i / ngon * 2.0f * 3.14159265f;
+        float r = (i % 2 == 0) ? 0.8f : 0.5f;
+        poly[i] = { std::cos(a) * r, std::sin(a) * r };
+        px[i] = poly[i].x;
+        py[i] = poly[i].y;
+    }
+    float2 minp, maxp;
+    MinMax(poly, ngon, minp, maxp);
+
+    int n = mesh.num_vertices;
+    RawVector<float2> spos;
+    spos.resize_discard(n);
+    auto mvp = mesh.getMVP();
+    for (int vi = 0; vi < n; ++vi) {
+        float3 p = mul_p(mvp, mesh.points[vi]);
+        spos[vi] = { p.x, p.y };
+    }
+
+    Bench("PolyInside", "Generic", n, [&]() {
+        int c = 0;
+        for (int vi = 0; vi < n; ++vi) { c += PolyInside_Generic(poly, ngon, minp, maxp, spos[vi]); }
+        g_sink = (float)c;
+    });
+#if defined(muEnableISPC) && defined(muSIMD_PolyInside)
+    Bench("PolyInside", "ISPC", n, [&]() {
+        int c = 0;
+        for (int vi = 0; vi < n; ++vi) { c += PolyInside_ISPC(poly, ngon, minp, maxp, spos[vi]); }
+        g_sink = (float)c;
+    });
+#endif
+    Bench("PolyInsideSoA", "Generic", n, [&]() {
+        int c = 0;
+        for (int vi = 0; vi < n; ++vi) { c += PolyInside_Generic(px, py, ngon, minp, maxp, spos[vi]); }
+        g_sink = (float)c;
+    });
+#if defined(muEnableISPC) && defined(muSIMD_PolyInsideSoA)
+    Bench("PolyInsideSoA", "ISPC", n, [&]() {
+        int c = 0;
+        for (int vi = 0; vi < n; ++vi) { c += PolyInside_ISPC(px, py, ngon, minp, maxp, spos[vi]); }
+        g_sink = (float)c;
+    });
+#endif
+}
+
+
+// end-to-end. impl is the implementation the library dispatches to.
+#ifdef muEnableISPC
+    #define npBenchImpl "Native(ISPC)"
+#else
+    #define npBenchImpl "Native"
+#endif
+
+static void BenchEntryPoints(TestMesh& mesh)
+{
+    int n = mesh.num_vertices;
+    RawVector<float> selection;
+    selection.resize_zeroclear(n);
+
+    // work on copies as some of the entry points modify the mesh
+    RawVector<float3> points = mesh.points, normals = mesh.normals;
+    RawVector<float4> tangents = mesh.tangents;
+
+    npMeshData model;
+    model.indices = mesh.indices.data();
+    model.vertices = points.data();
+    model.normals = normals.data();
+    model.tangents = tangents.data();
+    model.uv = mesh.uv.data();
+    model.selection = selection.data();
+    model.num_vertices = n;
+    model.num_triangles = mesh.num_triangles;
+
+    auto mvp = mesh.getMVP();
+    float3 campos = { mesh.size.x * 0.5f, 10.0f, mesh.size.z * 0.5f };
+    float2 rmin = { -0.5f, -0.5f }, rmax = { 0.5f, 0.5f };
+
+    {
+        RawVector<float3> tpoints, tnormals;
+        RawVector<float2> tuv;
+        RawVector<int> tindices;
+        tpoints.resize_discard(n); tnormals.resize_discard(n); tuv.resize_discard(n);
+        tindices.resize_discard(mesh.num_triangles * 3);
+        Bench("npGenerateTerrainMesh", npBenchImpl, n, [&]() {
+            npGenerateTerrainMesh(mesh.heightmap.data(), mesh.width, mesh.height, mesh.size,
+                tpoints.data(), tnormals.data(), tuv.data(), tindices.data());
+        });
+
+        // all chunks one by one into the same buffers, as streaming would do
+        const int tile_size = 64;
+        Bench("npGenerateTerrainChunk", npBenchImpl, n, [&]() {
+            int nv, nt;
+            for (int ty = 0; npGetTerrainChunkSize(mesh.width, mesh.height, tile_size, 0, 0, ty, &nv, &nt); ++ty) {
+                for (int tx = 0; npGetTerrainChunkSize(mesh.width, mesh.height, tile_size, 0, tx, ty, &nv, &nt); ++tx) {
+                    npGenerateTerrainChunk(mesh.heightmap.data(), mesh.width, mesh.height, mesh.size, tile_size, 0, tx, ty,
+                        tpoints.data(), tnormals.data(), tuv.data(), tindices.data());
+                }
+            }
+        });
+    }
+
+    {
+        // the terrain is one connected component. MikkTSpace mode is not parallelized in this case.
+        RawVector<float4> ttangents;
+        ttangents.resize_discard(n);
+        Bench("npGenerateTangents", npBenchImpl, n, [&]() {
+            npGenerateTangents(&model, ttangents.data(), npTangentsMode::Fast);
+        });
+        Bench("npGenerateTangents(MikkTSpace)", npBenchImpl, n, [&]() {
+            npGenerateTangents(&model, ttangents.data(), npTangentsMode::MikkTSpace);
+        });
+    }
+
+    Bench("npSelectRect", npBenchImpl, n, [&]() {
+        g_sink = (float)npSelectRect(&model, &mvp, rmin, rmax, campos, 1.0f, npVisibilityAll);
+    });
+    Bench("npSelectRect(DepthBuffer)", npBenchImpl, n, [&]() {
+        g_sink = (float)npSelectRect(&model, &mvp, rmin, rmax, campos, 1.0f, npVisibilityDepthBuffer);
+    });
+    {
+        // projected vertices and the grid are reused
+        npMeshData cmodel = model;
+        cmodel.context = npCreateMeshContext();
+        Bench("npSelectRect(Context)", npBenchImpl, n, [&]() {
+            g_sink = (float)npSelectRect(&cmodel, &mvp, rmin, rmax, campos, 1.0f, npVisibilityAll);
+        });
+        npReleaseMeshContext(cmodel.context);
+    }
+
+    {
+        // project to a coarse terrain slightly above. rays are cast in batch against the BVH of the target.
+        TestMesh target;
+        target.size = mesh.size;
+        target.build(64 * 64);
+        for (auto& p : target.points) { p.y += 0.1f; }
+
+        npMeshData tdata;
+        tdata.indices = target.indices.data();
+        tdata.vertices = target.points.data();
+        tdata.normals = target.normals.data();
+        tdata.num_vertices = target.num_vertices;
+        tdata.num_triangles = target.num_triangles;
+
+        Bench("npProjectVertices", npBenchImpl, n, [&]() {
+            npProjectVertices(&model, &tdata, mesh.normals.data(), npProjectVerticesMode::ForwardAndBackward, FLT_MAX, 1, 0);
+        });
+    }
+
+    {
+        const int num_bones = 16;
+        RawVector<Weights4> weights;
+        weights.resize_discard(n);
+        for (int vi = 0; vi < n; ++vi) {
+            for (int i = 0; i < 4; ++i) {
+                weights[vi].indices[i] = (vi + i) % num_bones;
+                weights[vi].weights[i] = 0.25f;
+            }
+        }
+        float4x4 bones[num_bones], bindposes[num_bones];
+        for (int bi = 0; bi < num_bones; ++bi) {
+            bones[bi] = to_mat4x4(rotateY(bi * 0.1f));
+            bindposes[bi] = float4x4::identity();
+        }
+
+        npSkinData skin;
+        skin.weights = weights.data();
+        skin.bones = bones;
+        skin.bindposes = bindposes;
+        skin.num_vertices = n;
+        skin.num_bones = num_bones;
+
+        Bench("npApplySkinning", npBenchImpl, n, [&]() {
+            npApplySkinning(&skin, mesh.points.data(), mesh.normals.data(), mesh.tangents.data(),
+                points.data(), normals.data(), tangents.data());
+        });
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    int max_size = 1000000;
+    if (argc > 1) { max_size = std::max<int>(std::atoi(argv[1]), 1000); }
+    if (argc > 2) { g_min_time = (nanosec)std::max<int>(std::atoi(argv[2]), 1) * 1000000; }
+
+    PrintHeader();
+    for (int size = 1000; size <= max_size; size *= 10) {
+        TestMesh mesh;
+        mesh.build(size);
+
+        BenchVertexKernels(mesh);
+        BenchSkinningKernels(mesh);
+        BenchTriangleKernels(mesh);
+        BenchPolyInside(mesh);
+        BenchEntryPoints(mesh);
+    }
+    return 0;
+}
@@ -3,30 +3,6 @@
 
 #define npEpsilon 0.0000001f
 
-struct npMeshData
-{
-    int         *indices = nullptr;
-    float3      *vertices = nullptr;
-    float3      *normals = nullptr;
-    float4      *tangents = nullptr;
-    float2      *uv = nullptr;
-    float       *selection = nullptr;
-    int         num_vertices = 0;
-    int         num_triangles = 0;
-    float4x4    transform = float4x4::identity();
-};
-
-struct npSkinData
-{
-    Weights4    *weights = nullptr;
-    float4x4    *bones = nullptr;
-    float4x4    *bindposes = nullptr;
-    int         num_vertices = 0;
-    int         num_bones = 0;
-    float4x4    root = float4x4::identity();
-};
-
-
 inline static int Raycast(
     const npMeshData& model, const float3 pos, const float3 dir, int& tindex, float& distance)
 {
@@ -34,7 +10,9 @@ inline static int Raycast(
     float3 rpos = mul_p(itrans, pos);
     float3 rdir = normalize(mul_v(itrans, dir));
     float d;
-    int hit = RayTrianglesIntersectionIndexed(rpos, rdir, model.vertices, model.indices, model.num_triangles, tindex, d);
+    int hit = model.context ?
+        model.context->getBVH(model).raycast(rpos, rdir, tindex, d) :
+        RayTrianglesIntersectionIndexed(rpos, rdir, model.vertices, model.indices, model.num_triangles, tindex, d);
     if (hit) {
         float3 hpos = rpos + rdir * d;
         distance = length(mul_p(model.transform, hpos) - pos);
@@ -54,76 +32,130 @@ inline static int RaycastWithoutTransform(
     return hit;
 }
 
-#define npVertexBlockSize 1024
+inline static int RaycastWithoutTransform(
+    const TriangleBVH& bvh, const float3 pos, const float3 dir, int& tindex, float& distance)
+{
+    float d;
+    int hit = bvh.raycast(pos, dir, tindex, d);
+    if (hit) {
+        float3 hpos = pos + dir * d;
+        distance = length(hpos - pos);
+    }
+    return hit;
+}
 
-template<class Body>
-inline static int SelectInside(const npMeshData& model, float3 pos, float radius, const Body& body, bool parallel = false)
+// Prepare: [](int num_targets) -> void
+// Body: [](int block, int vi, float distance, float3 world_pos) -> void
+// vertices are tested in blocks of npVertexBlockSize targets (grid candidates or all vertices). prepare is called
+// before any body with the number of targets. block is the index of the block the hit belongs to. blocks are processed
+// in parallel if parallel is true, but hits in a block are always processed in order by a thread.
+template<class Prepare, class Body>
+inline static int SelectInsideBlocks(const npMeshData& model, float3 pos, float radius, const Prepare& prepare, const Body& body, bool parallel)
 {
+    muProfileScope("SelectInside", model.num_vertices);
+    ScratchScope scratch;
     auto num_vertices = model.num_vertices;
     auto vertices = model.vertices;
     auto transform = model.transform;
 
-    float rq = radius * radius;
-    auto do_select = [&](int vi) -> bool {
-        float3 p = mul_p(transform, vertices[vi]);
-        float dsq = length_sq(p - pos);
-        if (dsq <= rq) {
-            body(vi, std::sqrt(dsq), p);
-            return true;;
+    // SoA mirror. available only if model has a context.
+    const npVerticesSoA *soa = nullptr;
+
+    // test [begin, end) of candidates (vertices of the mirror), or of all vertices if candidates is null, by SIMD in chunks.
+    // hits come out in ascending order of the range.
+    auto select_range = [&](const int *candidates, int begin, int end) -> int {
+        const int ChunkSize = 256;
+        int hits[ChunkSize];
+        float distances[ChunkSize];
+        float x[ChunkSize], y[ChunkSize], z[ChunkSize];
+        int ret = 0;
+        for (int i = begin; i < end; i += ChunkSize) {
+            int n = std::min(end - i, ChunkSize);
+            int num_hits;
+            if (candidates) {
+                num_hits = SelectInsideSoA(transform, soa->x.data(), soa->y.data(), soa->z.data(), candidates + i, n, pos, radius, hits, distances);
+            }
+            else {
+                Deinterleave(x, y, z, vertices + i, n);
+                num_hits = SelectInsideSoA(transform, x, y, z, nullptr, n, pos, radius, hits, distances);
+            }
+            int block = i / npVertexBlockSize;
+            for (int hi = 0; hi < num_hits; ++hi) {
+                int vi = candidates ? hits[hi] : i + hits[hi];
+                body(block, vi, distances[hi], mul_p(transform, vertices[vi]));
+            }
+            ret += num_hits;
         }
-        return false;
+        return ret;
     };
 
+    ScratchVector<int> candidates;
+    const int *pcandidates = nullptr;
+    int num_targets = num_vertices;
+    if (model.context) {
+        // gather candidates from the grid. the sphere becomes an ellipsoid in local space.
+        auto itrans = invert(transform);
+        float3 lpos = mul_p(itrans, pos);
+        float3 ax = mul_v(itrans, float3{ 1.0f, 0.0f, 0.0f });
+        float3 ay = mul_v(itrans, float3{ 0.0f, 1.0f, 0.0f });
+        float3 az = mul_v(itrans, float3{ 0.0f, 0.0f, 1.0f });
+        float3 extent = sqrt(ax * ax + ay * ay + az * az) * radius;
+
+        model.context->getVertexGrid(model).eachPointsInBox(lpos - extent, lpos + extent, [&](int vi) {
+            candidates.push_back(vi);
+        });
+        // keep same order as linear search
+        std::sort(candidates.begin(), candidates.end());
+        soa = &model.context->getVerticesSoA(model);
+
+        pcandidates = candidates.data();
+        num_targets = (int)candidates.size();
+    }
+    prepare(num_targets);
+
     if (parallel) {
         std::atomic_int ret{ 0 };
-        parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int vi, int vend) {
-            int c = 0;
-            for (; vi < vend; ++vi) {
-                if (do_select(vi)) {
-                    ++c;
-                }
-            }
-            ret += c;
+        parallel_for_blocked(0, num_targets, npVertexBlockSize, [&](int begin, int end) {
+            ret += select_range(pcandidates, begin, end);
         });
         return ret;
     }
     else {
-        int ret = 0;
-        for (int vi = 0; vi < num_vertices; ++vi) {
-            if (do_select(vi)) {
-                ++ret;
-            }
-        }
-        return ret;
+        return select_range(pcandidates, 0, num_targets);
     }
 }
 
-static bool GetFurthestDistance(const npMeshData& model, float3 pos, bool mask, int &vidx, float &dist)
+// Body: [](int vi, float distance, float3 world_pos) -> void
+template<class Body>
+inline static int SelectInside(const npMeshData& model, float3 pos, float radius, const Body& body, bool parallel = false)
 {
-    auto num_vertices = model.num_vertices;
-    auto vertices = model.vertices;
-    auto selection = model.selection;
-
-    float furthest_sq = FLT_MIN;
-    int furthest_vi;
+    return SelectInsideBlocks(model, pos, radius, [](int) {},
+        [&](int, int vi, float d, float3 p) { body(vi, d, p); }, parallel);
+}
 
-    float3 lpos = mul_p(invert(model.transform), pos);
-    for (int vi = 0; vi < num_vertices; ++vi) {
-        if (!mask || selection[vi] > 0.0f) {
-            float dsq = length_sq(vertices[vi] - lpos);
-            if (dsq > furthest_sq) {
-                furthest_sq = dsq;
-                furthest_vi = vi;
-            }
+// (vertex index, distance) of vertices inside the sphere. same order as SelectInside() but gathered in parallel.
+static void GatherInside(const npMeshData& model, float3 pos, float radius, ScratchVector<std::pair<int, float>>& dst)
+{
+    // each block writes to its own slot and the slots are packed afterwards
+    ScratchVector<int> counts;
+    SelectInsideBlocks(model, pos, radius,
+        [&](int num_targets) {
+            dst.resize_discard(num_targets);
+            counts.resize_zeroclear(ceildiv(num_targets, npVertexBlockSize));
+        },
+        [&](int block, int vi, float d, float3) {
+            dst[block * npVertexBlockSize + counts[block]++] = { vi, d };
+        }, true);
+
+    int n = 0;
+    for (int bi = 0; bi < (int)counts.size(); ++bi) {
+        auto *src = &dst[bi * npVertexBlockSize];
+        if (src != &dst[n]) {
+            std::move(src, src + counts[bi], &dst[n]); // dst[n] precedes src, so forward move is safe on overlap
         }
+        n += counts[bi];
     }
-
-    if (furthest_sq > FLT_MIN) {
-        dist = length(mul_p(model.transform, vertices[furthest_vi]) - pos);
-        vidx = furthest_vi;
-        return true;
-    }
-    return false;
+    dst.resize(n);
 }
 
 static inline int GetBrushSampleIndex(float distance, float bradius, int num_bsamples)
@@ -135,16 +167,152 @@ static inline float GetBrushSample(float distance, float bradius, float bsamples
     return bsamples[GetBrushSampleIndex(distance, bradius, num_bsamples)];
 }
 
+static inline float SegmentDistanceSq(float3 p, float3 a, float3 b)
+{
+    float3 ab = b - a;
+    float l = length_sq(ab);
+    float t = l > 0.0f ? clamp01(dot(p - a, ab) / l) : 0.0f;
+    return length_sq(p - (a + ab * t));
+}
+
+// vertices that can be affected by a brush stroke (polyline of dabs). the stroke covers the union of
+// capsules around its segments. the candidates are gathered once and each dab only tests nearby ones.
+class BrushStroke
+{
+public:
+    // dabs: centers of dabs in world space
+    BrushStroke(const npMeshData& model, const float3 dabs[], int num_dabs, float radius)
+        : m_radius(radius)
+    {
+        if (num_dabs <= 0 || radius <= 0.0f) { return; }
+
+        auto num_vertices = model.num_vertices;
+        auto vertices = model.vertices;
+        auto transform = model.transform;
+        float rq = radius * radius;
+
+        auto inside_capsules = [&](float3 p, int first_segment, int last_segment) -> bool {
+            if (num_dabs == 1) { return length_sq(p - dabs[0]) <= rq; }
+            for (int si = first_segment; si < last_segment; ++si) {
+                if (SegmentDistanceSq(p, dabs[si], dabs[si + 1]) <= rq) { return true; }
+            }
+            return false;
+        };
+
+        RawVector<char> marks;
+        marks.resize(num_vertices);
+        marks.zeroclear();
+        if (model.context) {
+            // a box query per segment. the sphere becomes an ellipsoid in local space.
+            auto itrans = invert(transform);
+            float3 ax = mul_v(itrans, float3{ 1.0f, 0.0f, 0.0f });
+            float3 ay = mul_v(itrans, float3{ 0.0f, 1.0f, 0.0f });
+            float3 az = mul_v(itrans, float3{ 0.0f, 0.0f, 1.0f });
+            float3 extent = sqrt(ax * ax + ay * ay + az * az) * radius;
+
+            auto& grid = model.context->getVertexGrid(model);
+            int num_segments = std::max<int>(num_dabs - 1, 1);
+            for (int si = 0; si < num_segments; ++si) {
+                float3 a = mul_p(itrans, dabs[si]);
+                float3 b = mul_p(itrans, dabs[std::min<int>(si + 1, num_dabs - 1)]);
+                grid.eachPointsInBox(min(a, b) - extent, max(a, b) + extent, [&](int vi) {
+                    if (!marks[vi] && inside_capsules(mul_p(transform, vertices[vi]), si, si + 1)) {
+                        marks[vi] = 1;
+                    }
+                });
+            }
+        }
+        else {
+            float3 bmin, bmax;
+            MinMax(dabs, num_dabs, bmin, bmax);
+            float3 r = { radius, radius, radius };
+            bmin -= r;
+            bmax += r;
+            parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int vi, int vend) {
+                for (; vi < vend; ++vi) {
+                    float3 p = mul_p(transform, vertices[vi]);
+                    if (p.x >= bmin.x && p.x <= bmax.x &&
+                        p.y >= bmin.y && p.y <= bmax.y &&
+                        p.z >= bmin.z && p.z <= bmax.z &&
+                        inside_capsules(p, 0, num_dabs - 1))
+                    {
+                        marks[vi] = 1;
+                    }
+                }
+            });
+        }
+
+        for (int vi = 0; vi < num_vertices; ++vi) {
+            if (marks[vi]) {
+                m_indices.push_back(vi);
+                m_positions.push_back(mul_p(transform, vertices[vi]));
+            }
+        }
+        m_affected.resize(m_indices.size());
+        m_affected.zeroclear();
+        m_grid.build(m_positions.data(), (int)m_positions.size(), radius);
+    }
+
+    // Body: [](int vi, float distance, float3 world_pos) -> void
+    // same as SelectInside() but only takes candidates of the stroke. vertices are processed in index order.
+    template<class Body>
+    int eachVerticesInside(float3 pos, const Body& body, bool parallel = false)
+    {
+        float rq = m_radius * m_radius;
+        m_hits.clear();
+        m_grid.eachPointsInSphere(pos, m_radius, [&](int ci) {
+            if (length_sq(m_positions[ci] - pos) <= rq) {
+                m_hits.push_back(ci);
+                m_affected[ci] = 1;
+            }
+        });
+        // candidates are sorted by vertex index
+        std::sort(m_hits.begin(), m_hits.end());
+
+        int num_hits = (int)m_hits.size();
+        auto do_body = [&](int hi) {
+            int ci = m_hits[hi];
+            float3 p = m_positions[ci];
+            body(m_indices[ci], length(p - pos), p);
+        };
+        if (parallel) {
+            parallel_for_blocked(0, num_hits, npVertexBlockSize, [&](int hi, int hend) {
+                for (; hi < hend; ++hi) { do_body(hi); }
+            });
+        }
+        else {
+            for (int hi = 0; hi < num_hits; ++hi) { do_body(hi); }
+        }
+        return num_hits;
+    }
+
+    // number of vertices processed by eachVerticesInside() so far
+    int getNumAffected() const
+    {
+        return (int)std::count(m_affected.begin(), m_affected.end(), 1);
+    }
+
+private:
+    float m_radius = 0.0f;
+    RawVector<int> m_indices;
+    RawVector<float3> m_positions; // world space
+    RawVector<char> m_affected;
+    SpatialHashGrid m_grid;
+    RawVector<int> m_hits;
+};
+
 
 npAPI int npRaycast(
     npMeshData *model, const float3 pos, const float3 dir, int *tindex, float *distance)
 {
+    npProfileScope(model->num_vertices);
     return Raycast(*model, pos, dir, *tindex, *distance);
 }
 
 npAPI float3 npPickNormal(
     npMeshData *model, const float3 pos, int ti)
 {
+    npProfileScope(model->num_vertices);
     auto indices = model->indices;
     auto points = model->vertices;
     auto normals = model->normals;
@@ -156,88 +324,110 @@ npAPI float3 npPickNormal(
     return normalize(mul_v(model->transform, r));
 }
 
+// per-vertex visibility test for frontface_only selections
+class VisibilityTest
+{
+public:
+    // lcampos: camera position in local space
+    VisibilityTest(const npMeshData& model, const float4x4& mvp, float3 lcampos, int mode)
+        : m_model(model), m_lcampos(lcampos)
+    {
+        // any non-zero value other than npVisibilityDepthBuffer means ray casting (compatible with old frontface_only flag)
+        m_mode = mode == npVisibilityDepthBuffer ? npVisibilityDepthBuffer : mode ? npVisibilityRaycast : npVisibilityAll;
+        if (m_mode == npVisibilityRaycast) {
+            // use BVH (cached one if model has context)
+            m_bvh = &GetBVH(model, m_bvh_tmp);
+        }
+        else if (m_mode == npVisibilityDepthBuffer) {
+            muProfileScope("DepthBuffer::build", model.num_triangles);
+            m_depth.build(mvp, model.vertices, model.indices, model.num_triangles, npDepthBufferSize, npDepthBufferSize);
+        }
+    }
+
+    // clip_pos: vertices[vi] transformed by mvp
+    bool operator()(int vi, const float4& clip_pos) const
+    {
+        if (m_mode == npVisibilityRaycast) {
+            // cast a ray toward the vertex and see if it hits near the vertex
+            float3 vpos = m_model.vertices[vi];
+            float3 dir = normalize(vpos - m_lcampos);
+            int ti;
+            float distance;
+            if (RaycastWithoutTransform(*m_bvh, m_lcampos, dir, ti, distance)) {
+                float3 hitpos = m_lcampos + dir * distance;
+                return length(vpos - hitpos) < 0.01f;
+            }
+            return false;
+        }
+        else if (m_mode == npVisibilityDepthBuffer) {
+            return m_depth.isVisible(clip_pos);
+        }
+        return true;
+    }
+
+private:
+    const npMeshData& m_model;
+    float3 m_lcampos;
+    int m_mode;
+    TriangleBVH m_bvh_tmp;
+    const TriangleBVH *m_bvh = nullptr;
+    DepthBuffer m_depth;
+};
+
 static bool npSelectNearestImpl(npMeshData *model, const float4x4 *mvp_, float2 rmin, float2 rmax, float3 campos, int frontface_only,
     int& pick_index)
 {
-    auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto normals = model->normals;
-    auto selection = model->selection;
 
     float4x4 mvp = *mvp_;
     float3 lcampos = mul_p(invert(model->transform), campos);
-    float2 rcenter = (rmin + rmax) * 0.5f;
 
-    const int max_inside = 64;
-    std::pair<int, float> insider[max_inside];
-    int num_inside = 0;
+    VisibilityTest visible(*model, mvp, lcampos, frontface_only);
+    float2 rcenter = (rmin + rmax) * 0.5f;
 
+    struct Nearest
     {
-        // gather vertices inside rect
-        std::atomic_int num_inside_a{ 0 };
-        parallel_for(0, num_vertices, [&](int vi) {
-            float4 vp = mul4(mvp, vertices[vi]);
-            float2 sp = float2{ vp.x, vp.y } / vp.w;
-            if (sp.x >= rmin.x && sp.x <= rmax.x &&
-                sp.y >= rmin.y && sp.y <= rmax.y && vp.z > 0.0f)
-            {
-                bool hit = false;
-                if (frontface_only) {
-                    float3 vpos = vertices[vi];
-                    float3 dir = normalize(vpos - lcampos);
-                    int ti;
-                    float distance;
-                    if (RaycastWithoutTransform(*model, lcampos, dir, ti, distance)) {
-                        float3 hitpos = lcampos + dir * distance;
-                        if (length(vpos - hitpos) < 0.01f) {
-                            hit = true;
-                        }
-                    }
-                }
-                else {
-                    hit = true;
-                }
-
-                if (hit) {
-                    int ii = num_inside_a++;
-                    if (ii < max_inside) {
-                        insider[ii].first = vi;
-                        insider[ii].second = length(sp - rcenter);
-                    }
-                }
-            }
-        });
-        num_inside = std::min<int>(num_inside_a, max_inside);
-    }
+        int index;
+        float distance; // from center of rect
+        float facing;
+    };
+    auto nearer = [](const Nearest& a, const Nearest& b) -> Nearest {
+        if (a.index == -1) { return b; }
+        if (b.index == -1) { return a; }
+        // if there are vertices with identical position, pick most camera-facing one
+        if (near_equal(a.distance, b.distance, npEpsilon)) {
+            if (a.facing != b.facing) { return a.facing < b.facing ? a : b; }
+            return a.index < b.index ? a : b;
+        }
+        return a.distance < b.distance ? a : b;
+    };
 
-    if (num_inside > 0) {
-        // search nearest from center of rect
-        int nearest_index = 0;
-        float nearest_distance = FLT_MAX;
-        float nearest_facing = 1.0f;
-
-        for (int ii = 0; ii < num_inside; ++ii) {
-            int vi = insider[ii].first;
-            float distance = insider[ii].second;
-            float3 dir = normalize(vertices[vi] - lcampos);
-
-            // if there are vertices with identical position, pick most camera-facing one 
-            if (near_equal(distance, nearest_distance, npEpsilon)) {
-                float facing = dot(normals[vi], dir);
-                if (facing < nearest_facing) {
-                    nearest_index = vi;
-                    nearest_distance = distance;
-                    nearest_facing = facing;
+    npProjectedVertices proj_tmp;
+    auto& proj = GetProjectedVertices(*model, mvp, proj_tmp);
+    RawVector<int> candidates;
+    proj.grid.gatherPointsInRect(rmin, rmax, candidates);
+
+    // search nearest from center of rect among all visible vertices inside rect
+    auto nearest = parallel_reduce(0, (int)candidates.size(), npVertexBlockSize, Nearest{ -1, FLT_MAX, 1.0f },
+        [&](int ci, int cend, Nearest r) {
+            for (; ci < cend; ++ci) {
+                int vi = candidates[ci];
+                float2 sp = proj.getScreenPos(vi);
+                if (sp.x >= rmin.x && sp.x <= rmax.x &&
+                    sp.y >= rmin.y && sp.y <= rmax.y && proj.z[vi] > 0.0f &&
+                    visible(vi, proj.getClipPos(vi)))
+                {
+                    float3 dir = normalize(vertices[vi] - lcampos);
+                    r = nearer(r, Nearest{ vi, length(sp - rcenter), dot(normals[vi], dir) });
                 }
             }
-            else if (distance < nearest_distance) {
-                nearest_index = vi;
-                nearest_distance = distance;
-                nearest_facing = dot(normals[vi], dir);
-            }
-        }
+            return r;
+        },
+        nearer);
 
-        pick_index = nearest_index;
+    if (nearest.index != -1) {
+        pick_index = nearest.index;
         return true;
     }
     return false;
@@ -246,6 +436,7 @@ static bool npSelectNearestImpl(npMeshData *model, const float4x4 *mvp_, float2
 npAPI int npPickVertex(
     npMeshData *model, const float4x4 *mvp_, float2 rmin, float2 rmax, float3 campos, int frontface_only, int *vi, float3 *vpos)
 {
+    npProfileScope(model->num_vertices);
     int pick_index = -1;
     if (npSelectNearestImpl(model, mvp_, rmin, rmax, campos, frontface_only, pick_index)) {
         *vi = pick_index;
@@ -258,6 +449,7 @@ npAPI int npPickVertex(
 npAPI int npSelectSingle(
     npMeshData *model, const float4x4 *mvp_, float2 rmin, float2 rmax, float3 campos, float strength, int frontface_only)
 {
+    npProfileScope(model->num_vertices);
     int pick_index;
     if (npSelectNearestImpl(model, mvp_, rmin, rmax, campos, frontface_only, pick_index)) {
         auto selection = model->selection;
@@ -271,6 +463,7 @@ npAPI int npSelectSingle(
 npAPI int npSelectTriangle(
     npMeshData *model, const float3 pos, const float3 dir, float strength)
 {
+    npProfileScope(model->num_vertices);
     auto indices = model->indices;
     auto selection = model->selection;
 
@@ -288,8 +481,8 @@ npAPI int npSelectTriangle(
 npAPI int npSelectEdge(
     npMeshData *model, float strength, int clear, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto indices = IArray<int>(model->indices, model->num_triangles * 3);
-    auto vertices = IArray<float3>(model->vertices, model->num_vertices);
     auto selection = model->selection;
     int num_vertices = model->num_vertices;
 
@@ -311,8 +504,12 @@ npAPI int npSelectEdge(
 
     if (clear) { memset(selection, 0, num_vertices * 4); }
 
+    // topology is cached in the context. walking costs are proportional to the selected region.
+    ConnectionData connection_tmp;
+    auto& connection = GetConnection(*model, connection_tmp);
+
     int ret = 0;
-    SelectEdge(indices, 3, vertices, targets, [&](int vi) {
+    SelectEdge(indices, 3, connection, targets, [&](int vi) {
         selection[vi] = clamp01(selection[vi] + strength);
         ++ret;
     });
@@ -322,8 +519,8 @@ npAPI int npSelectEdge(
 npAPI int npSelectHole(
     npMeshData *model, float strength, int clear, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto indices = IArray<int>(model->indices, model->num_triangles * 3);
-    auto vertices = IArray<float3>(model->vertices, model->num_vertices);
     auto selection = model->selection;
     int num_vertices = model->num_vertices;
 
@@ -345,8 +542,12 @@ npAPI int npSelectHole(
 
     if (clear) { memset(selection, 0, num_vertices * 4); }
 
+    // welded to walk across UV seams etc.
+    ConnectionData connection_tmp;
+    auto& connection = GetWeldedConnection(*model, connection_tmp);
+
     int ret = 0;
-    SelectHole(indices, 3, vertices, targets, [&](int vi) {
+    SelectHole(indices, 3, connection, targets, [&](int vi) {
         selection[vi] = clamp01(selection[vi] + strength);
         ++ret;
     });
@@ -356,8 +557,8 @@ npAPI int npSelectHole(
 npAPI int npSelectConnected(
     npMeshData *model, float strength, int clear)
 {
+    npProfileScope(model->num_vertices);
     auto indices = IArray<int>(model->indices, model->num_triangles * 3);
-    auto vertices = IArray<float3>(model->vertices, model->num_vertices);
     auto selection = model->selection;
     int num_vertices = model->num_vertices;
 
@@ -371,8 +572,11 @@ npAPI int npSelectConnected(
 
     if (clear) { memset(selection, 0, num_vertices * 4); }
 
+    ConnectionData connection_tmp;
+    auto& connection = GetConnection(*model, connection_tmp);
+
     int ret = 0;
-    SelectConnected(indices, 3, vertices, targets, [&](int vi) {
+    SelectConnected(indices, 3, connection, targets, [&](int vi) {
         selection[vi] = clamp01(selection[vi] + strength);
         ++ret;
     });
@@ -383,39 +587,29 @@ npAPI int npSelectRect(
     npMeshData *model,
     const float4x4 *mvp_, float2 rmin, float2 rmax, float3 campos, float strength, int frontface_only)
 {
-    auto num_vertices = model->num_vertices;
-    auto vertices = model->vertices;
-    auto normals = model->normals;
+    npProfileScope(model->num_vertices);
     auto selection = model->selection;
 
     float4x4 mvp = *mvp_;
     float3 lcampos = mul_p(invert(model->transform), campos);
 
+    VisibilityTest visible(*model, mvp, lcampos, frontface_only);
+
+    npProjectedVertices proj_tmp;
+    auto& proj = GetProjectedVertices(*model, mvp, proj_tmp);
+    RawVector<int> candidates;
+    proj.grid.gatherPointsInRect(rmin, rmax, candidates);
+
     std::atomic_int ret{ 0 };
-    parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int vi, int vend) {
+    parallel_for_blocked(0, (int)candidates.size(), npVertexBlockSize, [&](int ci, int cend) {
         int c = 0;
-        for (; vi < vend; ++vi) {
-            float4 vp = mul4(mvp, vertices[vi]);
-            float2 sp = float2{ vp.x, vp.y } / vp.w;
+        for (; ci < cend; ++ci) {
+            int vi = candidates[ci];
+            float2 sp = proj.getScreenPos(vi);
             if (sp.x >= rmin.x && sp.x <= rmax.x &&
-                sp.y >= rmin.y && sp.y <= rmax.y && vp.z > 0.0f)
+                sp.y >= rmin.y && sp.y <= rmax.y && proj.z[vi] > 0.0f)
             {
-                bool hit = false;
-                if (frontface_only) {
-                    float3 vpos = vertices[vi];
-                    float3 dir = normalize(vpos - lcampos);
-                    int ti;
-                    float distance;
-                    if (RaycastWithoutTransform(*model, lcampos, dir, ti, distance)) {
-                        float3 hitpos = lcampos + dir * distance;
-                        if (length(vpos - hitpos) < 0.01f) {
-                            hit = true;
-                        }
-                    }
-                }
-                else {
-                    hit = true;
-                }
+                bool hit = visible(vi, proj.getClipPos(vi));
 
                 if (hit) {
                     selection[vi] = clamp01(selection[vi] + strength);
@@ -432,49 +626,40 @@ npAPI int npSelectLasso(
     npMeshData *model,
     const float4x4 *mvp_, const float2 lasso[], int num_lasso_points, float3 campos, float strength, int frontface_only)
 {
+    npProfileScope(model->num_vertices);
     if (num_lasso_points < 3) { return 0; }
+    ScratchScope scratch;
 
-    auto num_vertices = model->num_vertices;
-    auto vertices = model->vertices;
-    auto normals = model->normals;
     auto selection = model->selection;
 
     float4x4 mvp = *mvp_;
     float3 lcampos = mul_p(invert(model->transform), campos);
 
+    VisibilityTest visible(*model, mvp, lcampos, frontface_only);
+
     float2 minp, maxp;
     MinMax(lasso, num_lasso_points, minp, maxp);
 
-    RawVector<float> polyx, polyy;
+    ScratchVector<float> polyx, polyy;
     polyx.resize(num_lasso_points); polyy.resize(num_lasso_points);
     for (int i = 0; i < num_lasso_points; ++i) {
         polyx[i] = lasso[i].x;
         polyy[i] = lasso[i].y;
     }
 
+    npProjectedVertices proj_tmp;
+    auto& proj = GetProjectedVertices(*model, mvp, proj_tmp);
+    RawVector<int> candidates;
+    proj.grid.gatherPointsInRect(minp, maxp, candidates);
+
     std::atomic_int ret{ 0 };
-    parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int vi, int vend) {
+    parallel_for_blocked(0, (int)candidates.size(), npVertexBlockSize, [&](int ci, int cend) {
         int c = 0;
-        for (; vi < vend; ++vi) {
-            float4 vp = mul4(mvp, vertices[vi]);
-            float2 sp = float2{ vp.x, vp.y } / vp.w;
+        for (; ci < cend; ++ci) {
+            int vi = candidates[ci];
+            float2 sp = proj.getScreenPos(vi);
             if (PolyInside(polyx.data(), polyy.data(), num_lasso_points, minp, maxp, sp)) {
-                bool hit = false;
-                if (frontface_only) {
-                    float3 vpos = vertices[vi];
-                    float3 dir = normalize(vpos - lcampos);
-                    int ti;
-                    float distance;
-                    if (RaycastWithoutTransform(*model, lcampos, dir, ti, distance)) {
-                        float3 hitpos = lcampos + dir * distance;
-                        if (length(vpos - hitpos) < 0.01f) {
-                            hit = true;
-                        }
-                    }
-                }
-                else {
-                    hit = true;
-                }
+                bool hit = visible(vi, proj.getClipPos(vi));
 
                 if (hit) {
                     selection[vi] = clamp01(selection[vi] + strength);
@@ -491,9 +676,10 @@ npAPI int npSelectBrush(
     npMeshData *model,
     const float3 pos, float radius, float strength, int num_bsamples, float bsamples[])
 {
+    npProfileScope(model->num_vertices);
     auto selection = model->selection;
 
-    return SelectInside(*model, pos, radius, [&](int vi, float d, float3 p) {
+    return SelectInside(*model, pos, radius, [&](int vi, float d, float3 /*p*/) {
         float s = GetBrushSample(d, radius, bsamples, num_bsamples) * strength;
         selection[vi] = clamp01(selection[vi] + s);
     }, true);
@@ -503,26 +689,41 @@ npAPI int npUpdateSelection(
     npMeshData *model,
     float3 *selection_pos, float3 *selection_normal)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto normals = model->normals;
     auto selection = model->selection;
 
-    float st = 0.0f;
-    int num_selected = 0;
-    float3 spos = float3::zero();
-    float3 snormal = float3::zero();
-    quatf srot = quatf::identity();
+    struct Accum
+    {
+        float3 spos;
+        float3 snormal;
+        float st;
+        int num_selected;
+    };
+    auto accum = parallel_reduce(0, num_vertices, npVertexBlockSize, Accum{ float3::zero(), float3::zero(), 0.0f, 0 },
+        [&](int vi, int vend, Accum r) {
+            for (; vi < vend; ++vi) {
+                float s = selection[vi];
+                if (s > 0.0f) {
+                    r.spos += vertices[vi] * s;
+                    r.snormal += normals[vi] * s;
+                    ++r.num_selected;
+                    r.st += s;
+                }
+            }
+            return r;
+        },
+        [](const Accum& a, const Accum& b) {
+            return Accum{ a.spos + b.spos, a.snormal + b.snormal, a.st + b.st, a.num_selected + b.num_selected };
+        });
 
-    for (int vi = 0; vi < num_vertices; ++vi) {
-        float s = selection[vi];
-        if (s > 0.0f) {
-            spos += vertices[vi] * s;
-            snormal += normals[vi] * s;
-            ++num_selected;
-            st += s;
-        }
-    }
+    float st = accum.st;
+    int num_selected = accum.num_selected;
+    float3 spos = accum.spos;
+    float3 snormal = accum.snormal;
+    quatf srot = quatf::identity();
 
     if (num_selected > 0) {
         auto trans = model->transform;
@@ -541,43 +742,82 @@ npAPI int npUpdateSelection(
 npAPI void npAssignVertices(
     npMeshData *model, float3 value, float4x4 trans, int xyz, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto selection = model->selection;
     auto itrans = invert(trans);
-
-    for (int vi = 0; vi < num_vertices; ++vi) {
-        float s = mask ? selection[vi] : 1.0f;
-        if (s == 0.0f) continue;
-
-        float3 v1 = mul_p(trans, vertices[vi]);
-        float3 v2 = v1;
-        if (xyz & 1) v2.x = value.x;
-        if (xyz & 2) v2.y = value.y;
-        if (xyz & 4) v2.z = value.z;
-        vertices[vi] = mul_p(itrans, lerp(v1, v2, s));
+    auto modified = GetModifiedBits(*model);
+
+    auto soa = model->context ? &model->context->getVerticesSoA(*model) : nullptr;
+
+    // transform to trans space and back by SIMD in chunks. vertices with zero weight are left untouched.
+    // the SoA mirror is updated along with vertices.
+    parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int begin, int end) {
+        const int ChunkSize = 256;
+        float x[ChunkSize], y[ChunkSize], z[ChunkSize];
+        for (int ci = begin; ci < end; ci += ChunkSize) {
+            int n = std::min(end - ci, ChunkSize);
+            if (soa) {
+                MulPointsSoA(trans, &soa->x[ci], &soa->y[ci], &soa->z[ci], x, y, z, n);
+            }
+            else {
+                Deinterleave(x, y, z, vertices + ci, n);
+                MulPointsSoA(trans, x, y, z, x, y, z, n);
+            }
+            for (int i = 0; i < n; ++i) {
+                float s = mask ? selection[ci + i] : 1.0f;
+                if (xyz & 1) x[i] = lerp(x[i], value.x, s);
+                if (xyz & 2) y[i] = lerp(y[i], value.y, s);
+                if (xyz & 4) z[i] = lerp(z[i], value.z, s);
+            }
+            MulPointsSoA(itrans, x, y, z, x, y, z, n);
+            for (int i = 0; i < n; ++i) {
+                int vi = ci + i;
+                float s = mask ? selection[vi] : 1.0f;
+                if (s == 0.0f) continue;
+
+                vertices[vi] = { x[i], y[i], z[i] };
+                if (soa) {
+                    soa->x[vi] = x[i];
+                    soa->y[vi] = y[i];
+                    soa->z[vi] = z[i];
+                }
+                MarkModified(modified, vi);
+            }
+        }
+    });
+    MarkDirty(*model, npDirtyVertices);
+    if (soa) {
+        model->context->validateVerticesSoA(*model);
     }
 }
 
 npAPI void npMoveVertices(
     npMeshData *model, float3 value, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto selection = model->selection;
 
+    auto modified = GetModifiedBits(*model);
+
     value = mul_v(invert(model->transform), value);
     for (int vi = 0; vi < num_vertices; ++vi) {
         float s = mask ? selection[vi] : 1.0f;
         if (s == 0.0f) continue;
 
         vertices[vi] = (vertices[vi] + value * s);
+        MarkModified(modified, vi);
     }
+    MarkDirty(*model, npDirtyVertices);
 }
 
 npAPI void npRotatePivotVertices(
     npMeshData *model, quatf value, float3 pivot_pos, quatf pivot_rot, int mask)
 {
+    npProfileScope(model->num_vertices);
     float3 axis;
     float angle;
     to_axis_angle(value, axis, angle);
@@ -597,17 +837,21 @@ npAPI void npRotatePivotVertices(
     auto to_pivot_space = trans * iptrans;
     auto to_local_space = ptrans * itrans;
     auto rotation = to_pivot_space * to_mat4x4(value) * to_local_space;
+    auto modified = GetModifiedBits(*model);
 
     for (int vi = 0; vi < num_vertices; ++vi) {
         float s = mask ? selection[vi] : 1.0f;
         if (s == 0.0f) continue;
         vertices[vi] = lerp(vertices[vi], mul_p(rotation, vertices[vi]), s);
+        MarkModified(modified, vi);
     }
+    MarkDirty(*model, npDirtyVertices);
 }
 
 npAPI void npScaleVertices(
     npMeshData *model, float3 value, float3 pivot_pos, quatf pivot_rot, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto selection = model->selection;
@@ -620,28 +864,37 @@ npAPI void npScaleVertices(
     auto to_pivot_space = trans * iptrans;
     auto to_local_space = ptrans * itrans;
     auto scale = to_pivot_space * scale44(value) * to_local_space;
+    auto modified = GetModifiedBits(*model);
 
     for (int vi = 0; vi < num_vertices; ++vi) {
         float s = mask ? selection[vi] : 1.0f;
         if (s == 0.0f) continue;
         vertices[vi] = lerp(vertices[vi], mul_p(scale, vertices[vi]), s);
+        MarkModified(modified, vi);
     }
+    MarkDirty(*model, npDirtyVertices);
 }
 
 npAPI void npSmooth(
     npMeshData *model, float radius, float strength, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
-    auto vertices = model->vertices;
     auto normals = model->normals;
     auto selection = model->selection;
 
-    RawVector<float3> tvertices;
-    tvertices.resize(num_vertices);
-    parallel_for(0, num_vertices, [&](int vi) {
-        tvertices[vi] = mul_p(model->transform, vertices[vi]);
-    });
-
+    // source normals. without this, results depend on the order of processing.
+    ScratchScope scratch;
+    ScratchVector<float3> snormals;
+    snormals.assign(normals, normals + num_vertices);
+    auto modified = GetModifiedBits(*model);
+
+    // neighbors are searched per vertex so that only vertices to be smoothed pay for it.
+    // neighbor lists per vertex would take O(vertices * neighbors) memory with large radius.
+    ScratchVector<float3> tvertices_tmp;
+    auto tvertices = GetTransformedVertices(*model, model->transform, tvertices_tmp);
+    SpatialHashGrid grid;
+    grid.build(tvertices, num_vertices, radius);
     float rsq = radius * radius;
     parallel_for(0, num_vertices, [&](int vi) {
         float s = mask ? selection[vi] : 1.0f;
@@ -649,32 +902,39 @@ npAPI void npSmooth(
 
         float3 p = tvertices[vi];
         float3 average = float3::zero();
-        for (int i = 0; i < num_vertices; ++i) {
-            float s2 = selection ? selection[i] : 1.0f;
-            float dsq = length_sq(tvertices[i] - p);
-            if (dsq <= rsq) {
-                average += normals[i] * s2;
+        grid.eachPointsInSphere(p, radius, [&](int i) {
+            if (length_sq(tvertices[i] - p) <= rsq) {
+                float s2 = selection ? selection[i] : 1.0f;
+                average += snormals[i] * s2;
             }
-        }
+        });
         average = normalize(average);
-        normals[vi] = normalize(normals[vi] + average * (strength * s));
+        normals[vi] = normalize(snormals[vi] + average * (strength * s));
+        MarkModified(modified, vi);
     });
+    MarkDirty(*model, npDirtyNormals);
 }
 
 npAPI int npWeld(
     npMeshData *model, int smoothing, float weld_angle, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto normals = model->normals;
     auto selection = model->selection;
 
-    RawVector<bool> checked;
+    ScratchScope scratch;
+    ScratchVector<bool> checked;
     checked.resize(num_vertices);
     checked.zeroclear();
 
+    SpatialHashGrid grid_tmp;
+    auto& grid = GetVertexGrid(*model, grid_tmp);
+
     int ret = 0;
-    RawVector<int> shared;
+    ScratchVector<int> shared;
+    ScratchVector<int> candidates;
     for (int vi = 0; vi < num_vertices; ++vi) {
         if (checked[vi]) { continue; }
         float s = mask ? selection[vi] : 1.0f;
@@ -682,7 +942,12 @@ npAPI int npWeld(
 
         float3 p = vertices[vi];
         float3 n = normals[vi];
-        for (int i = 0; i < num_vertices; ++i) {
+
+        // n is accumulated. candidates must be processed in the order of index to get the same result as linear search.
+        candidates.clear();
+        grid.eachPointsInSphere(p, npEpsilon, [&](int i) { candidates.push_back(i); });
+        std::sort(candidates.begin(), candidates.end());
+        for (int i : candidates) {
             if (vi != i && !checked[i] &&
                 length(vertices[i] - p) < npEpsilon &&
                 angle_between(n, normals[i]) * Rad2Deg <= weld_angle)
@@ -703,6 +968,9 @@ npAPI int npWeld(
             ++ret;
         }
     }
+    if (ret > 0) {
+        MarkDirty(*model, npDirtyNormals);
+    }
 
     return ret;
 }
@@ -712,42 +980,41 @@ npAPI int npWeld2(
     npMeshData *model, int num_targets, npMeshData targets[],
     int weld_mode, float weld_angle, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto num_vertices = model->num_vertices;
-    auto vertices = model->vertices;
     auto normals = model->normals;
     auto selection = model->selection;
 
     float4x4 trans = model->transform;
     float4x4 itrans = invert(trans);
 
-    RawVector<float4x4> titrans;
-    RawVector<float3> wvertices, wnormals;
-    std::vector<RawVector<float3>> twvertices, twnormals;
+    ScratchScope scratch;
+    ScratchVector<float4x4> titrans;
+    ScratchVector<float3> wvertices_tmp, wnormals;
+    std::vector<const float3*> twvertices;
+    std::vector<ScratchVector<float3>> twvertices_tmp, twnormals;
 
     // generate world space vertices
-    wvertices.resize(num_vertices);
+    auto wvertices = GetTransformedVertices(*model, trans, wvertices_tmp);
     wnormals.resize(num_vertices);
     for (int vi = 0; vi < num_vertices; ++vi) {
-        wvertices[vi] = mul_p(trans, vertices[vi]);
         wnormals[vi] = mul_v(trans, normals[vi]);
     }
 
     titrans.resize(num_targets);
     twvertices.resize(num_targets);
+    twvertices_tmp.resize(num_targets);
     twnormals.resize(num_targets);
     for (int ti = 0; ti < num_targets; ++ti) {
         auto tt = targets[ti].transform;
         titrans[ti] = invert(tt);
 
-        auto tva = targets[ti].vertices;
         auto tna = targets[ti].normals;
-        auto& twva = twvertices[ti];
         auto& twna = twnormals[ti];
         int num_tv = targets[ti].num_vertices;
-        twva.resize(num_tv);
+        twvertices[ti] = GetTransformedVertices(targets[ti], tt, twvertices_tmp[ti]);
         twna.resize(num_tv);
         for (int tvi = 0; tvi < num_tv; ++tvi) {
-            twva[tvi] = mul_p(tt, tva[tvi]);
             twna[tvi] = mul_v(tt, tna[tvi]);
         }
     }
@@ -755,26 +1022,53 @@ npAPI int npWeld2(
     std::vector<RawVector<std::pair<int, int>>> weld_maps;
     weld_maps.resize(num_targets);
 
+    // progress is counted in blocks of model vertices. remaining blocks are skipped on cancellation.
+    int num_blocks = ceildiv(num_vertices, npVertexBlockSize);
+    auto job = npJob::getCurrent();
+    if (job) {
+        job->addWork((int64_t)num_targets * num_blocks);
+    }
+
     // generate weld maps
-    for (int ti = 0; ti < num_targets; ++ti) {
+    parallel_for(0, num_targets, [&](int ti) {
         auto& weld_map = weld_maps[ti];
+        auto twva = twvertices[ti];
+        auto& twna = twnormals[ti];
+        int num_tv = targets[ti].num_vertices;
 
-        for (int vi = 0; vi < num_vertices; ++vi) {
-            float s = mask ? selection[vi] : 1.0f;
-            if (s == 0.0f) { continue; }
-
-            auto p = wvertices[vi];
-            auto n = wnormals[vi];
-            auto& twva = twvertices[ti];
-            auto& twna = twnormals[ti];
-            int num_tv = targets[ti].num_vertices;
-            for (int tvi = 0; tvi < num_tv; ++tvi) {
-                if (length(twva[tvi] - p) < npEpsilon && angle_between(n, twna[tvi]) * Rad2Deg <= weld_angle) {
-                    weld_map.push_back({ vi, tvi });
+        SpatialHashGrid grid;
+        grid.build(twva, num_tv);
+
+        // gather per block and concatenate them to keep the order
+        std::vector<RawVector<std::pair<int, int>>> block_maps(num_blocks);
+        parallel_for(0, num_blocks, [&](int bi) {
+            if (job && job->checkCanceled()) { return; }
+            auto& block_map = block_maps[bi];
+            RawVector<int> candidates;
+            int vend = std::min<int>(npVertexBlockSize * (bi + 1), num_vertices);
+            for (int vi = npVertexBlockSize * bi; vi < vend; ++vi) {
+                float s = mask ? selection[vi] : 1.0f;
+                if (s == 0.0f) { continue; }
+
+                auto p = wvertices[vi];
+                auto n = wnormals[vi];
+                candidates.clear();
+                grid.eachPointsInSphere(p, npEpsilon, [&](int tvi) { candidates.push_back(tvi); });
+                std::sort(candidates.begin(), candidates.end());
+                for (int tvi : candidates) {
+                    if (length(twva[tvi] - p) < npEpsilon && angle_between(n, twna[tvi]) * Rad2Deg <= weld_angle) {
+                        block_map.push_back({ vi, tvi });
+                    }
                 }
             }
+            if (job) { job->advance(1); }
+        });
+        for (auto& block_map : block_maps) {
+            weld_map.insert(weld_map.end(), block_map.cdata(), block_map.cdata() + block_map.size());
         }
-    }
+    });
+
+    if (job && job->checkCanceled()) { return 0; } // weld maps are incomplete. leave normals untouched.
 
     int ret = 0;
     for (auto& map : weld_maps) { ret += (int)map.size(); }
@@ -804,7 +1098,7 @@ npAPI int npWeld2(
     }
     else if (weld_mode == 2) {
         // smooth
-        RawVector<float3> tmp_wnormals = wnormals;
+        ScratchVector<float3> tmp_wnormals = wnormals;
 
         for (int ti = 0; ti < num_targets; ++ti) {
             auto& weld_map = weld_maps[ti];
@@ -827,39 +1121,57 @@ npAPI int npWeld2(
             }
         }
     }
+
+    // 0 modifies targets, 1 the model and 2 both
+    if (weld_mode == 1 || weld_mode == 2) {
+        MarkDirty(*model, npDirtyNormals);
+    }
+    if (weld_mode == 0 || weld_mode == 2) {
+        for (int ti = 0; ti < num_targets; ++ti) {
+            MarkDirty(targets[ti], npDirtyNormals);
+        }
+    }
     return ret;
 }
 
 
-npAPI int npBrushReplace(
-    npMeshData *model,
-    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], float3 value, int mask)
+// per-vertex operations of brushes. shared by the single dab and the stroke versions.
+// operator(): pos: center of the dab, strength: strength of the dab, vi, d, p: see SelectInside()
+struct BrushReplace
 {
-    auto normals = model->normals;
-    auto selection = model->selection;
-    auto sign = strength < 0.0f ? -1.0f : 1.0f;
-
-    return SelectInside(*model, pos, radius, [&](int vi, float d, float3 p) {
+    float3 *normals;
+    const float *selection;
+    float radius;
+    int num_bsamples;
+    float *bsamples;
+    float3 value;
+    int mask;
+
+    void operator()(float3 /*pos*/, float strength, int vi, float d, float3 /*p*/) const
+    {
+        auto sign = strength < 0.0f ? -1.0f : 1.0f;
         float s = GetBrushSample(d, radius, bsamples, num_bsamples) * abs(strength);
         if (mask) s *= selection[vi];
 
         normals[vi] = normalize(normals[vi] + value * (s * sign));
-    }, true);
-    return 0;
-}
+    }
+};
 
-npAPI int npBrushPaint(
-    npMeshData *model,
-    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], float3 n, int blend_mode, int mask)
+struct BrushPaint
 {
-    auto normals = model->normals;
-    auto selection = model->selection;
-    auto sign = strength < 0.0f ? -1.0f : 1.0f;
-
-    float3 ln = n;
-    n = normalize(mul_v(model->transform, n));
-    auto itrans = invert(model->transform);
-    return SelectInside(*model, pos, radius, [&](int vi, float d, float3 p) {
+    float3 *normals;
+    const float *selection;
+    float radius;
+    int num_bsamples;
+    float *bsamples;
+    float3 n; // world space
+    float4x4 itrans;
+    int blend_mode;
+    int mask;
+
+    void operator()(float3 pos, float strength, int vi, float d, float3 p) const
+    {
+        auto sign = strength < 0.0f ? -1.0f : 1.0f;
         int bsi = GetBrushSampleIndex(d, radius, num_bsamples);
         float s = saturate(bsamples[bsi] * abs(strength) * 2.0f);
         if (mask) s *= selection[vi];
@@ -896,100 +1208,382 @@ npAPI int npBrushPaint(
         r = lerp(vn, r, s);
 
         normals[vi] = normalize(vn + r * s);
-    }, true);
-}
+    }
+};
 
-npAPI int npBrushLerp(
-    npMeshData *model,
-    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], const float3 n0[], const float3 n1[], int mask)
+struct BrushLerp
 {
-    auto normals = model->normals;
-    auto selection = model->selection;
-    auto sign = strength < 0.0f ? -1.0f : 1.0f;
-
-    return SelectInside(*model, pos, radius, [&](int vi, float d, float3 p) {
+    float3 *normals;
+    const float *selection;
+    float radius;
+    int num_bsamples;
+    float *bsamples;
+    const float3 *n0;
+    const float3 *n1;
+    int mask;
+
+    void operator()(float3 /*pos*/, float strength, int vi, float d, float3 /*p*/) const
+    {
+        auto sign = strength < 0.0f ? -1.0f : 1.0f;
         float s = GetBrushSample(d, radius, bsamples, num_bsamples) * abs(strength);
         if (mask) s *= selection[vi];
 
         normals[vi] = normalize(lerp(n1[vi], n0[vi] * sign, s));
-    }, true);
-}
+    }
+};
 
-npAPI int npBrushSmooth(
-    npMeshData *model,
-    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], int mask)
+// rays from vertices of model toward target, cast in batch by BVH of target (see TriangleBVH::raycast()).
+// rays are transformed into the local space of target. directions are not re-normalized so distances
+// of hits are parametric and equal to distances along ray_dirs in the local space of model.
+struct ProjectionRays
 {
-    auto normals = model->normals;
-    auto selection = model->selection;
+    ScratchVector<int> vertices; // model vertex index of each ray
+    ScratchVector<float3> pos, dir;
+    ScratchVector<int> tindices;
+    ScratchVector<float> distances;
 
-    RawVector<std::pair<int, float>> inside;
-    SelectInside(*model, pos, radius, [&](int vi, float d, float3 p) {
-        inside.push_back({ vi, d });
-    });
+    int size() const { return (int)vertices.size(); }
 
-    float3 average = float3::zero();
-    for (auto& p : inside) {
-        average += normals[p.first];
+    // vertices whose selection is 0 are skipped if mask is true
+    template<class RayDirs>
+    void setup(const npMeshData& model, const RayDirs& ray_dirs, const float4x4& to_target, bool mask)
+    {
+        vertices.clear();
+        for (int vi = 0; vi < model.num_vertices; ++vi) {
+            if (!mask || model.selection[vi] != 0.0f) {
+                vertices.push_back(vi);
+            }
+        }
+        int num_rays = size();
+        pos.resize_discard(num_rays);
+        dir.resize_discard(num_rays);
+        tindices.resize_discard(num_rays);
+        distances.resize_discard(num_rays);
+        parallel_for(0, num_rays, [&](int ri) {
+            int vi = vertices[ri];
+            pos[ri] = mul_p(to_target, model.vertices[vi]);
+            dir[ri] = mul_v(to_target, ray_dirs[vi]);
+        });
     }
-    average = normalize(average);
 
-    for (auto& p : inside) {
-        // ignore sign of strength
-        float s = GetBrushSample(p.second, radius, bsamples, num_bsamples) * abs(strength);
-        if (mask) s *= selection[p.first];
+    // with job, rays are cast in slices to report progress and stop on cancellation. returns false if stopped before all rays are cast.
+    bool cast(const TriangleBVH& bvh, float max_distance, npJob *job = nullptr)
+    {
+        if (!job) {
+            bvh.raycast(size(), pos.cdata(), dir.cdata(), max_distance, tindices.data(), distances.data());
+            return true;
+        }
 
-        normals[p.first] = normalize(normals[p.first] + average * s);
+        const int slice = 16384;
+        for (int rb = 0; rb < size(); rb += slice) {
+            if (job->checkCanceled()) { return false; }
+            int n = std::min<int>(size() - rb, slice);
+            bvh.raycast(n, pos.cdata() + rb, dir.cdata() + rb, max_distance, tindices.data() + rb, distances.data() + rb);
+            job->advance(n);
+        }
+        return true;
     }
-    return (int)inside.size();
-}
 
-template<class RayDirs>
-inline int BrushProjectionImpl(
-    npMeshData *model,
-    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], int mask,
-    npMeshData *normal_source, const RayDirs& ray_dirs)
-{
-    auto vertices = model->vertices;
-    auto normals = model->normals;
-    auto selection = model->selection;
+    void flip()
+    {
+        parallel_for(0, size(), [&](int ri) { dir[ri] = -dir[ri]; });
+    }
 
-    auto pnum_triangles = normal_source->num_triangles;
-    auto pnormals = normal_source->normals;
-    auto pindices = normal_source->indices;
+    // hit position in the local space of target
+    float3 getHitPos(int ri) const { return pos[ri] + dir[ri] * distances[ri]; }
+};
 
-    auto to_local = normal_source->transform * invert(model->transform);
-    RawVector<float3> pvertices;
-    pvertices.resize(normal_source->num_vertices);
-    for (int vi = 0; vi < normal_source->num_vertices; ++vi) {
-        pvertices[vi] = mul_p(to_local, normal_source->vertices[vi]);
-    }
+// interpolate attributes of target at pos (in the local space of target) on triangle ti
+template<class T>
+static inline T InterpolateOnTriangle(const npMeshData& target, const T *attr, float3 pos, int ti)
+{
+    auto vertices = target.vertices;
+    auto indices = target.indices;
+    return triangle_interpolation(
+        pos,
+        vertices[indices[ti * 3 + 0]],
+        vertices[indices[ti * 3 + 1]],
+        vertices[indices[ti * 3 + 2]],
+        attr[indices[ti * 3 + 0]],
+        attr[indices[ti * 3 + 1]],
+        attr[indices[ti * 3 + 2]]);
+}
 
-    auto sign = strength < 0.0f ? -1.0f : 1.0f;
+template<class RayDirs>
+struct BrushProjection
+{
+    float3 *vertices;
+    float3 *normals;
+    const float *selection;
+    float radius;
+    int num_bsamples;
+    float *bsamples;
+    int mask;
+    const RayDirs& ray_dirs;
+
+    // rays are cast in the local space of normal source
+    const npMeshData& source;
+    float4x4 to_local, to_source;
+    const TriangleBVH *bvh;
+    TriangleBVH bvh_tmp;
+
+    BrushProjection(npMeshData *model, float radius_, int num_bsamples_, float bsamples_[], int mask_,
+        npMeshData *normal_source, const RayDirs& ray_dirs_)
+        : vertices(model->vertices), normals(model->normals), selection(model->selection)
+        , radius(radius_), num_bsamples(num_bsamples_), bsamples(bsamples_), mask(mask_), ray_dirs(ray_dirs_)
+        , source(*normal_source)
+    {
+        to_local = normal_source->transform * invert(model->transform);
+        to_source = invert(to_local);
+        bvh = &GetBVH(*normal_source, bvh_tmp);
+    }
 
-    return SelectInside(*model, pos, radius, [&](int vi, float d, float3 p) {
+    void operator()(float3 /*pos*/, float strength, int vi, float d, float3 /*p*/) const
+    {
+        auto sign = strength < 0.0f ? -1.0f : 1.0f;
         float s = GetBrushSample(d, radius, bsamples, num_bsamples) * abs(strength);
         if (mask) s *= selection[vi];
 
-        float3 rpos = vertices[vi];
-        float3 rdir = ray_dirs[vi];
+        // direction is not re-normalized to keep the distance parametric
+        float3 rpos = mul_p(to_source, vertices[vi]);
+        float3 rdir = mul_v(to_source, ray_dirs[vi]);
         int ti;
         float distance;
-        int num_hit = RayTrianglesIntersectionIndexed(rpos, rdir, pvertices.data(), pindices, pnum_triangles, ti, distance);
-
-        if (num_hit > 0) {
-            float3 result = triangle_interpolation(
-                rpos + rdir * distance,
-                { pvertices[pindices[ti * 3 + 0]] },
-                { pvertices[pindices[ti * 3 + 1]] },
-                { pvertices[pindices[ti * 3 + 2]] },
-                pnormals[pindices[ti * 3 + 0]],
-                pnormals[pindices[ti * 3 + 1]],
-                pnormals[pindices[ti * 3 + 2]]);
-
+        if (bvh->raycast(rpos, rdir, ti, distance)) {
+            float3 result = InterpolateOnTriangle(source, source.normals, rpos + rdir * distance, ti);
             result = normalize(mul_v(to_local, result));
             normals[vi] = normalize(lerp(normals[vi], result * sign, s));
         }
+    }
+};
+
+struct RayDir
+{
+    float3 ray_dir;
+    const float3& operator[](int) const { return ray_dir; }
+};
+
+template<class Brush>
+static inline int ApplyDab(const npMeshData& model, float3 pos, float radius, float strength, const Brush& brush)
+{
+    auto modified = GetModifiedBits(model);
+    int ret = SelectInside(model, pos, radius, [&](int vi, float d, float3 p) {
+        brush(pos, strength, vi, d, p);
+        MarkModified(modified, vi);
     }, true);
+    // all brushes modify normals
+    if (ret > 0) {
+        MarkDirty(model, npDirtyNormals);
+    }
+    return ret;
+}
+
+// apply brush to each dab of the stroke in order. pressures (optional) scales strength of each dab.
+// returns number of vertices affected by any of dabs.
+template<class Brush>
+static inline int ApplyStroke(const npMeshData& model, const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, const Brush& brush)
+{
+    auto modified = GetModifiedBits(model);
+    BrushStroke stroke(model, dabs, num_dabs, radius);
+    for (int di = 0; di < num_dabs; ++di) {
+        float3 pos = dabs[di];
+        float s = pressures ? strength * pressures[di] : strength;
+        stroke.eachVerticesInside(pos, [&](int vi, float d, float3 p) {
+            brush(pos, s, vi, d, p);
+            MarkModified(modified, vi);
+        }, true);
+    }
+    int ret = stroke.getNumAffected();
+    if (ret > 0) {
+        MarkDirty(model, npDirtyNormals);
+    }
+    return ret;
+}
+
+
+npAPI int npBrushReplace(
+    npMeshData *model,
+    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], float3 value, int mask)
+{
+    npProfileScope(model->num_vertices);
+    BrushReplace brush{ model->normals, model->selection, radius, num_bsamples, bsamples, value, mask };
+    return ApplyDab(*model, pos, radius, strength, brush);
+}
+
+npAPI int npBrushReplaceStroke(
+    npMeshData *model,
+    const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, int num_bsamples, float bsamples[], float3 value, int mask)
+{
+    npProfileScope(model->num_vertices);
+    BrushReplace brush{ model->normals, model->selection, radius, num_bsamples, bsamples, value, mask };
+    return ApplyStroke(*model, dabs, pressures, num_dabs, radius, strength, brush);
+}
+
+npAPI int npBrushPaint(
+    npMeshData *model,
+    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], float3 n, int blend_mode, int mask)
+{
+    npProfileScope(model->num_vertices);
+    BrushPaint brush{ model->normals, model->selection, radius, num_bsamples, bsamples,
+        normalize(mul_v(model->transform, n)), invert(model->transform), blend_mode, mask };
+    return ApplyDab(*model, pos, radius, strength, brush);
+}
+
+npAPI int npBrushPaintStroke(
+    npMeshData *model,
+    const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, int num_bsamples, float bsamples[], float3 n, int blend_mode, int mask)
+{
+    npProfileScope(model->num_vertices);
+    BrushPaint brush{ model->normals, model->selection, radius, num_bsamples, bsamples,
+        normalize(mul_v(model->transform, n)), invert(model->transform), blend_mode, mask };
+    return ApplyStroke(*model, dabs, pressures, num_dabs, radius, strength, brush);
+}
+
+npAPI int npBrushLerp(
+    npMeshData *model,
+    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], const float3 n0[], const float3 n1[], int mask)
+{
+    npProfileScope(model->num_vertices);
+    BrushLerp brush{ model->normals, model->selection, radius, num_bsamples, bsamples, n0, n1, mask };
+    return ApplyDab(*model, pos, radius, strength, brush);
+}
+
+npAPI int npBrushLerpStroke(
+    npMeshData *model,
+    const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, int num_bsamples, float bsamples[], const float3 n0[], const float3 n1[], int mask)
+{
+    npProfileScope(model->num_vertices);
+    BrushLerp brush{ model->normals, model->selection, radius, num_bsamples, bsamples, n0, n1, mask };
+    return ApplyStroke(*model, dabs, pressures, num_dabs, radius, strength, brush);
+}
+
+// inside: vertices in the dab and distances from its center, in index order.
+// connection is needed only by npSmoothMode::Laplacian and must be welded (see GetWeldedConnection()).
+// results: temporary for npSmoothMode::Laplacian. heap memory so that strokes can reuse it across dabs.
+static void BrushSmoothImpl(
+    npMeshData *model, const ScratchVector<std::pair<int, float>>& inside, npSmoothMode mode, const ConnectionData *connection,
+    float radius, float strength, int num_bsamples, float bsamples[], int mask, RawVector<float3>& results)
+{
+    auto normals = model->normals;
+    auto indices = model->indices;
+    auto selection = model->selection;
+    auto modified = GetModifiedBits(*model);
+    int num_inside = (int)inside.size();
+
+    // ignore sign of strength
+    auto get_strength = [&](int i) {
+        float s = GetBrushSample(inside[i].second, radius, bsamples, num_bsamples) * abs(strength);
+        if (mask) s *= selection[inside[i].first];
+        return s;
+    };
+
+    if (mode == npSmoothMode::Laplacian) {
+        // average of one-ring neighbors. results go to a temporary as neighbors are read while updating.
+        // vertices without strength or connected faces keep their normals (results[i] == normals[vi]).
+        results.resize_discard(num_inside);
+        parallel_for_blocked(0, num_inside, npVertexBlockSize, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                int vi = inside[i].first;
+                float3 n = normals[vi];
+                results[i] = n;
+                float s = get_strength(i);
+                if (s == 0.0f) { continue; }
+
+                float3 average = float3::zero();
+                connection->eachConnectedFaces(connection->weld_map[vi], [&](int fi, int ii) {
+                    for (int ci = 0; ci < 3; ++ci) {
+                        int ni = indices[fi * 3 + ci];
+                        if (fi * 3 + ci != ii) { average += normals[ni]; }
+                    }
+                });
+                if (length_sq(average) > 0.0f) {
+                    results[i] = normalize(n + normalize(average) * s);
+                }
+            }
+        });
+        parallel_for_blocked(0, num_inside, npVertexBlockSize, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                int vi = inside[i].first;
+                if (results[i] == normals[vi]) { continue; }
+                normals[vi] = results[i];
+                MarkModified(modified, vi);
+            }
+        });
+    }
+    else {
+        // average of all vertices in the dab
+        float3 average = parallel_reduce(0, num_inside, npVertexBlockSize, float3::zero(),
+            [&](int begin, int end, float3 r) {
+                for (int i = begin; i < end; ++i) { r += normals[inside[i].first]; }
+                return r;
+            },
+            [](const float3& a, const float3& b) { return a + b; });
+        if (length_sq(average) == 0.0f) { return; }
+        average = normalize(average);
+
+        parallel_for_blocked(0, num_inside, npVertexBlockSize, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                float s = get_strength(i);
+                if (s == 0.0f) { continue; }
+                int vi = inside[i].first;
+                normals[vi] = normalize(normals[vi] + average * s);
+                MarkModified(modified, vi);
+            }
+        });
+    }
+    if (num_inside > 0) {
+        MarkDirty(*model, npDirtyNormals);
+    }
+}
+
+npAPI int npBrushSmooth(
+    npMeshData *model,
+    const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], int mask, npSmoothMode mode)
+{
+    npProfileScope(model->num_vertices);
+    ConnectionData connection_tmp;
+    const ConnectionData *connection = nullptr;
+    if (mode == npSmoothMode::Laplacian) {
+        connection = &GetWeldedConnection(*model, connection_tmp);
+    }
+
+    ScratchScope scratch;
+    ScratchVector<std::pair<int, float>> inside;
+    RawVector<float3> results;
+    GatherInside(*model, pos, radius, inside);
+    BrushSmoothImpl(model, inside, mode, connection, radius, strength, num_bsamples, bsamples, mask, results);
+    return (int)inside.size();
+}
+
+npAPI int npBrushSmoothStroke(
+    npMeshData *model,
+    const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, int num_bsamples, float bsamples[], int mask, npSmoothMode mode)
+{
+    npProfileScope(model->num_vertices);
+    ConnectionData connection_tmp;
+    const ConnectionData *connection = nullptr;
+    if (mode == npSmoothMode::Laplacian) {
+        connection = &GetWeldedConnection(*model, connection_tmp);
+    }
+
+    ScratchScope scratch;
+    BrushStroke stroke(*model, dabs, num_dabs, radius);
+    ScratchVector<std::pair<int, float>> inside;
+    RawVector<float3> results;
+    for (int di = 0; di < num_dabs; ++di) {
+        inside.clear();
+        stroke.eachVerticesInside(dabs[di], [&](int vi, float d, float3 /*p*/) {
+            inside.push_back({ vi, d });
+        });
+        float s = pressures ? strength * pressures[di] : strength;
+        BrushSmoothImpl(model, inside, mode, connection, radius, s, num_bsamples, bsamples, mask, results);
+    }
+    return stroke.getNumAffected();
 }
 
 npAPI int npBrushProjection(
@@ -997,7 +1591,22 @@ npAPI int npBrushProjection(
     const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], int mask,
     npMeshData *normal_source, float3 ray_dirs[])
 {
-    return BrushProjectionImpl(model, pos, radius, strength, num_bsamples, bsamples, mask, normal_source, ray_dirs);
+    npProfileScope(model->num_vertices);
+    const float3 *dirs = ray_dirs;
+    BrushProjection<const float3*> brush(model, radius, num_bsamples, bsamples, mask, normal_source, dirs);
+    return ApplyDab(*model, pos, radius, strength, brush);
+}
+
+npAPI int npBrushProjectionStroke(
+    npMeshData *model,
+    const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, int num_bsamples, float bsamples[], int mask,
+    npMeshData *normal_source, float3 ray_dirs[])
+{
+    npProfileScope(model->num_vertices);
+    const float3 *dirs = ray_dirs;
+    BrushProjection<const float3*> brush(model, radius, num_bsamples, bsamples, mask, normal_source, dirs);
+    return ApplyStroke(*model, dabs, pressures, num_dabs, radius, strength, brush);
 }
 
 npAPI int npBrushProjection2(
@@ -1005,56 +1614,38 @@ npAPI int npBrushProjection2(
     const float3 pos, float radius, float strength, int num_bsamples, float bsamples[], int mask,
     npMeshData *normal_source, float3 ray_dir)
 {
-    struct RayDir
-    {
-        float3 ray_dir;
-        const float3& operator[](int) const { return ray_dir; }
-    } ray_dirs = { ray_dir };
-    return BrushProjectionImpl(model, pos, radius, strength, num_bsamples, bsamples, mask, normal_source, ray_dirs);
+    npProfileScope(model->num_vertices);
+    RayDir dirs = { ray_dir };
+    BrushProjection<RayDir> brush(model, radius, num_bsamples, bsamples, mask, normal_source, dirs);
+    return ApplyDab(*model, pos, radius, strength, brush);
 }
 
+npAPI int npBrushProjection2Stroke(
+    npMeshData *model,
+    const float3 dabs[], const float pressures[], int num_dabs,
+    float radius, float strength, int num_bsamples, float bsamples[], int mask,
+    npMeshData *normal_source, float3 ray_dir)
+{
+    npProfileScope(model->num_vertices);
+    RayDir dirs = { ray_dir };
+    BrushProjection<RayDir> brush(model, radius, num_bsamples, bsamples, mask, normal_source, dirs);
+    return ApplyStroke(*model, dabs, pressures, num_dabs, radius, strength, brush);
+}
 
 npAPI int npBuildMirroringRelation(
     npMeshData *model, float3 mirror_plane, float epsilon, int relation[])
 {
-    if (!relation) { return 0; }
-
-    // per-vertex detection
-    auto num_vertices = model->num_vertices;
-    auto vertices = model->vertices;
-    auto normals = model->normals;
-
-    RawVector<float> distances;
-    distances.resize(num_vertices);
-    parallel_for(0, num_vertices, [&](int vi) {
-        distances[vi] = plane_distance(vertices[vi], mirror_plane);
-    });
+    npProfileScope(model->num_vertices);
+    if (!relation && !model->context) { return 0; }
 
-    std::atomic_int ret{ 0 };
-    parallel_for(0, num_vertices, [&](int vi) {
-        int rel = -1;
-        float d1 = distances[vi];
-        if (d1 < 0.0f) {
-            for (int i = 0; i < num_vertices; ++i) {
-                float d2 = distances[i];
-                if (d2 > 0.0f &&
-                    length(vertices[vi] - (vertices[i] - mirror_plane * (d2 * 2.0f))) < epsilon)
-                {
-                    float3 n1 = normals[vi];
-                    float3 n2 = plane_mirror(normals[i], mirror_plane);
-                    if (dot(n1, n2) >= 0.99f) {
-                        rel = i;
-                        ++ret;
-                        break;
-                    }
-                }
-            }
-        }
-        else if (near_equal(d1, 0.0f)) {
-            rel = -2; // -2: on mirror plane
-        }
-        relation[vi] = rel;
-    });
+    // per-vertex detection. result is kept in the context and reused by npApplyMirroring().
+    RawVector<int> tmp;
+    int ret = 0;
+    auto rel = GetMirroringRelation(*model, mirror_plane, epsilon, tmp, ret);
+    if (!rel) { return 0; } // cancelled
+    if (relation) {
+        memcpy(relation, rel, sizeof(int) * model->num_vertices);
+    }
 
 #if 0
     // per-triangle detection
@@ -1147,35 +1738,56 @@ npAPI int npBuildMirroringRelation(
 npAPI void npApplyMirroring(
     npMeshData *model, const int relation[], float3 mirror_plane, float3 *vertices, float3 *normals, float4 *tangents)
 {
+    npProfileScope(model->num_vertices);
+    if (!relation && model->context) {
+        relation = model->context->findMirroringRelation(*model, mirror_plane);
+    }
     if (!relation) { return; }
 
     auto num_vertices = model->num_vertices;
+    // only modifications of the model's own buffers are tracked
+    auto modified = GetModifiedBits(*model);
+    auto modified_v = vertices == model->vertices ? modified : nullptr;
+    auto modified_n = normals == model->normals ? modified : nullptr;
+    auto modified_t = tangents == model->tangents ? modified : nullptr;
     if (vertices) {
         for (int vi = 0; vi < num_vertices; ++vi) {
             int ri = relation[vi];
             if (ri >= 0) {
                 vertices[ri] = plane_mirror(vertices[vi], mirror_plane);
+                MarkModified(modified_v, ri);
             }
             else if (ri == -2) {
                 // project to mirror plane
                 float3 v = vertices[vi];
                 float d = plane_distance(v, mirror_plane);
                 vertices[vi] = v - (mirror_plane * d);
+                MarkModified(modified_v, vi);
             }
         }
     }
+    if (vertices && vertices == model->vertices) {
+        MarkDirty(*model, npDirtyVertices);
+    }
     if (normals) {
         for (int vi = 0; vi < num_vertices; ++vi) {
             int ri = relation[vi];
-            if (ri >= 0)
+            if (ri >= 0) {
                 normals[ri] = plane_mirror(normals[vi], mirror_plane);
+                MarkModified(modified_n, ri);
+            }
         }
     }
+    if (normals && normals == model->normals) {
+        MarkDirty(*model, npDirtyNormals);
+    }
     if (tangents) {
         for (int vi = 0; vi < num_vertices; ++vi) {
             int ri = relation[vi];
-            if (ri >= 0)
+            if (ri >= 0) {
                 (float3&)tangents[ri] = plane_mirror((float3&)tangents[vi], mirror_plane);
+                MarkModified(modified_t, ri);
+            }
         }
     }
 }
@@ -1185,73 +1797,46 @@ template<class RayDirs>
 inline void ProjectNormalsImpl(
     npMeshData *model, npMeshData *target, const RayDirs& ray_dirs, int mask)
 {
-    auto num_vertices = model->num_vertices;
-    auto vertices = model->vertices;
     auto normals = model->normals;
     auto selection = model->selection;
-
-    auto pnum_triangles = target->num_triangles;
-    auto pvertices = target->vertices;
     auto pnormals = target->normals;
-    auto pindices = target->indices;
 
     auto to_local = target->transform * invert(model->transform);
-    RawVector<float> soa[9]; // flattened + SoA-nized vertices (faster on CPU)
+    TriangleBVH bvh_tmp;
+    const auto& bvh = GetBVH(*target, bvh_tmp);
+    auto modified = GetModifiedBits(*model);
 
-    // flatten + SoA-nize
-    {
-        for (int i = 0; i < 9; ++i) {
-            soa[i].resize(pnum_triangles);
-        }
-        for (int ti = 0; ti < pnum_triangles; ++ti) {
-            for (int i = 0; i < 3; ++i) {
-                auto p = mul_p(to_local, pvertices[pindices[ti * 3 + i]]);
-                soa[i * 3 + 0][ti] = p.x;
-                soa[i * 3 + 1][ti] = p.y;
-                soa[i * 3 + 2][ti] = p.z;
-            }
-        }
-    }
+    ScratchScope scratch;
+    ProjectionRays rays;
+    rays.setup(*model, ray_dirs, invert(to_local), mask != 0);
+    muProfileScope("ProjectNormals::RayTest", rays.size());
+    rays.cast(bvh, FLT_MAX);
 
-    parallel_for(0, num_vertices, [&](int vi) {
-        float s = mask ? selection[vi] : 1.0f;
-        if (s == 0.0f) { return; }
+    parallel_for(0, rays.size(), [&](int ri) {
+        int ti = rays.tindices[ri];
+        if (ti < 0) { return; }
 
-        float3 rpos = vertices[vi];
-        float3 rdir = ray_dirs[vi];
-        int ti;
-        float distance;
-        int num_hit = RayTrianglesIntersectionSoA(rpos, rdir,
-            soa[0].data(), soa[1].data(), soa[2].data(),
-            soa[3].data(), soa[4].data(), soa[5].data(),
-            soa[6].data(), soa[7].data(), soa[8].data(),
-            pnum_triangles, ti, distance);
-
-        if (num_hit > 0) {
-            float3 result = triangle_interpolation(
-                rpos + rdir * distance,
-                { soa[0][ti], soa[1][ti], soa[2][ti] },
-                { soa[3][ti], soa[4][ti], soa[5][ti] },
-                { soa[6][ti], soa[7][ti], soa[8][ti] },
-                pnormals[pindices[ti * 3 + 0]],
-                pnormals[pindices[ti * 3 + 1]],
-                pnormals[pindices[ti * 3 + 2]]);
-
-            result = normalize(mul_v(to_local, result));
-            normals[vi] = normalize(lerp(normals[vi], result, s));
-        }
+        int vi = rays.vertices[ri];
+        float s = mask ? selection[vi] : 1.0f;
+        float3 result = InterpolateOnTriangle(*target, pnormals, rays.getHitPos(ri), ti);
+        result = normalize(mul_v(to_local, result));
+        normals[vi] = normalize(lerp(normals[vi], result, s));
+        MarkModified(modified, vi);
     });
+    MarkDirty(*model, npDirtyNormals);
 }
 
 npAPI void npProjectNormals(
     npMeshData *model, npMeshData *target, const float3 ray_dirs[], int mask)
 {
+    npProfileScope(model->num_vertices);
     ProjectNormalsImpl(model, target, ray_dirs, mask);
 }
 
 npAPI void npProjectNormals2(
     npMeshData *model, npMeshData *target, const float3 ray_dir, int mask)
 {
+    npProfileScope(model->num_vertices);
     struct RayDir
     {
         float3 ray_dir;
@@ -1260,148 +1845,105 @@ npAPI void npProjectNormals2(
     ProjectNormalsImpl(model, target, ray_dirs, mask);
 }
 
-enum class npProjectVerticesMode
-{
-    Forward,
-    Backward,
-    ForwardAndBackward,
-};
-
 template<class RayDirs>
 void npProjectVerticesImpl(
     npMeshData *model, npMeshData *target, const RayDirs& ray_dirs, npProjectVerticesMode mode, float max_distance, int PNT, bool mask)
 {
-    auto num_vertices = model->num_vertices;
     auto vertices = model->vertices;
     auto normals = model->normals;
     auto tangents = model->tangents;
     auto selection = model->selection;
 
-    auto pnum_triangles = target->num_triangles;
-    auto pvertices = target->vertices;
     auto pnormals = target->normals;
     auto ptangents = target->tangents;
-    auto pindices = target->indices;
 
     auto to_local = target->transform * invert(model->transform);
-    RawVector<float> soa[9]; // flattened + SoA-nized vertices (faster on CPU)
-
-                             // flatten + SoA-nize
-    {
-        for (int i = 0; i < 9; ++i) {
-            soa[i].resize(pnum_triangles);
-        }
-        for (int ti = 0; ti < pnum_triangles; ++ti) {
-            for (int i = 0; i < 3; ++i) {
-                auto p = mul_p(to_local, pvertices[pindices[ti * 3 + i]]);
-                soa[i * 3 + 0][ti] = p.x;
-                soa[i * 3 + 1][ti] = p.y;
-                soa[i * 3 + 2][ti] = p.z;
-            }
-        }
+    TriangleBVH bvh_tmp;
+    const auto& bvh = GetBVH(*target, bvh_tmp);
+    auto modified = GetModifiedBits(*model);
+
+    bool forward = mode == npProjectVerticesMode::Forward || mode == npProjectVerticesMode::ForwardAndBackward;
+    bool backward = mode == npProjectVerticesMode::Backward || mode == npProjectVerticesMode::ForwardAndBackward;
+
+    // cast forward and backward rays in separate batches to keep rays in packets coherent
+    ScratchScope scratch;
+    ProjectionRays rays, brays;
+    rays.setup(*model, ray_dirs, invert(to_local), mask);
+    muProfileScope("ProjectVertices::RayTest", rays.size());
+
+    // nothing is modified if cancelled while casting
+    auto job = npJob::getCurrent();
+    if (job) {
+        job->addWork((int64_t)rays.size() * ((forward ? 1 : 0) + (backward ? 1 : 0)));
+    }
+    if (backward) {
+        brays = rays;
+        brays.flip();
+        if (!brays.cast(bvh, max_distance, job)) { return; }
+    }
+    if (forward) {
+        if (!rays.cast(bvh, max_distance, job)) { return; }
     }
 
-    parallel_for(0, num_vertices, [&](int vi) {
+    parallel_for(0, rays.size(), [&](int ri) {
+        int vi = rays.vertices[ri];
         float s = mask ? selection[vi] : 1.0f;
-        if (s == 0.0f) { return; }
 
-        float3 rpos = vertices[vi];
-        float3 rdir = ray_dirs[vi];
-        int ti;
-        float distance;
-
-        float3 rvertex;
-        float3 rnormal = float3::zero();
-        float4 rtangents = float4::zero();
-        float min_distance;
-        bool hit = false;
+        // pick nearer hit. forward one has priority if they are of same distance.
+        const ProjectionRays *hit = nullptr;
+        if (forward && rays.tindices[ri] >= 0) {
+            hit = &rays;
+        }
+        if (backward && brays.tindices[ri] >= 0 && (!hit || brays.distances[ri] < rays.distances[ri])) {
+            hit = &brays;
+        }
+        if (!hit) { return; }
 
-        auto gen_normal = [&soa, &to_local, pnormals, pindices](const float3& pos, int ti) {
-            if (pnormals) {
-                float3 ret = triangle_interpolation(
-                    pos,
-                    { soa[0][ti], soa[1][ti], soa[2][ti] },
-                    { soa[3][ti], soa[4][ti], soa[5][ti] },
-                    { soa[6][ti], soa[7][ti], soa[8][ti] },
-                    pnormals[pindices[ti * 3 + 0]],
-                    pnormals[pindices[ti * 3 + 1]],
-                    pnormals[pindices[ti * 3 + 2]]);
-                ret = normalize(mul_v(to_local, ret));
-                return ret;
-            }
-            else {
-                return float3::zero();
-            }
-        };
-        auto gen_tangent = [&soa, &to_local, ptangents, pindices](const float3& pos, int ti) {
-            if (ptangents) {
-                float4 ret = triangle_interpolation(
-                    pos,
-                    { soa[0][ti], soa[1][ti], soa[2][ti] },
-                    { soa[3][ti], soa[4][ti], soa[5][ti] },
-                    { soa[6][ti], soa[7][ti], soa[8][ti] },
-                    ptangents[pindices[ti * 3 + 0]],
-                    ptangents[pindices[ti * 3 + 1]],
-                    ptangents[pindices[ti * 3 + 2]]);
-                (float3&)ret = normalize(mul_v(to_local, (float3&)ret));
-                return ret;
-            }
-            else {
-                return float4::zero();
-            }
-        };
+        int ti = hit->tindices[ri];
+        float distance = hit->distances[ri];
+        float3 hpos = hit->getHitPos(ri);
+        float3 rdir = ray_dirs[vi];
+        if (hit == &brays) { rdir = -rdir; }
 
-        if (mode == npProjectVerticesMode::Forward || mode == npProjectVerticesMode::ForwardAndBackward) {
-            int num_hit = RayTrianglesIntersectionSoA(rpos, rdir,
-                soa[0].data(), soa[1].data(), soa[2].data(),
-                soa[3].data(), soa[4].data(), soa[5].data(),
-                soa[6].data(), soa[7].data(), soa[8].data(),
-                pnum_triangles, ti, distance);
-            if (num_hit > 0 && distance < max_distance) {
-                hit = true;
-                min_distance = distance;
-                rvertex = rpos + rdir * distance;
-                rnormal = gen_normal(rpos + rdir * distance, ti);
-                rtangents = gen_tangent(rpos + rdir * distance, ti);
-            }
+        if (PNT & 1) {
+            vertices[vi] = lerp(vertices[vi], vertices[vi] + rdir * distance, s);
         }
-        if (mode == npProjectVerticesMode::Backward || mode == npProjectVerticesMode::ForwardAndBackward) {
-            int num_hit = RayTrianglesIntersectionSoA(rpos, -rdir,
-                soa[0].data(), soa[1].data(), soa[2].data(),
-                soa[3].data(), soa[4].data(), soa[5].data(),
-                soa[6].data(), soa[7].data(), soa[8].data(),
-                pnum_triangles, ti, distance);
-            if (num_hit > 0 && distance < max_distance && (!hit || distance < min_distance)) {
-                hit = true;
-                min_distance = distance;
-                rvertex = rpos + -rdir * distance;
-                rnormal = gen_normal(rpos + -rdir * distance, ti);
-                rtangents = gen_tangent(rpos + -rdir * distance, ti);
+        if (normals && (PNT & 2)) {
+            float3 rnormal = float3::zero();
+            if (pnormals) {
+                rnormal = normalize(mul_v(to_local, InterpolateOnTriangle(*target, pnormals, hpos, ti)));
             }
+            normals[vi] = normalize(lerp(normals[vi], rnormal, s));
         }
-        if (hit) {
-            if (PNT & 1) {
-                vertices[vi] = lerp(vertices[vi], rvertex, s);
-            }
-            if (normals && (PNT & 2)) {
-                normals[vi] = normalize(lerp(normals[vi], rnormal, s));
-            }
-            if (tangents && (PNT & 4)) {
-                (float3&)tangents[vi] = normalize(lerp((float3&)tangents[vi], (float3&)rtangents, s));
+        if (tangents && (PNT & 4)) {
+            float4 rtangent = float4::zero();
+            if (ptangents) {
+                rtangent = InterpolateOnTriangle(*target, ptangents, hpos, ti);
+                (float3&)rtangent = normalize(mul_v(to_local, (float3&)rtangent));
             }
+            (float3&)tangents[vi] = normalize(lerp((float3&)tangents[vi], (float3&)rtangent, s));
         }
+        MarkModified(modified, vi);
     });
+    if (PNT & 1) {
+        MarkDirty(*model, npDirtyVertices);
+    }
+    if (normals && (PNT & 2)) {
+        MarkDirty(*model, npDirtyNormals);
+    }
 }
 
 npAPI void npProjectVertices(
     npMeshData *model, npMeshData *target, const float3 ray_dirs[], npProjectVerticesMode mode, float max_distance, int PNT, int mask)
 {
+    npProfileScope(model->num_vertices);
     npProjectVerticesImpl(model, target, ray_dirs, mode, max_distance, PNT, mask);
 }
 
 npAPI void npProjectVerticesRadial(
     npMeshData *model, npMeshData *target, const float3 center, npProjectVerticesMode mode, float max_distance, int PNT, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto to_local = invert(model->transform);
 
     struct RayDir
@@ -1422,6 +1964,7 @@ npAPI void npProjectVerticesRadial(
 npAPI void npProjectVerticesDirectional(
     npMeshData *model, npMeshData *target, const float3 ray_dir, npProjectVerticesMode mode, float max_distance, int PNT, int mask)
 {
+    npProfileScope(model->num_vertices);
     auto to_local = invert(model->transform);
 
     struct RayDir
@@ -1438,49 +1981,17 @@ npAPI void npProjectVerticesDirectional(
 
 template<int NumInfluence>
 static void SkinningImpl(
-    int num_vertices, const RawVector<float4x4>& poses, const Weights<NumInfluence> weights[],
+    int num_vertices, const ScratchVector<float4x4>& poses, const Weights<NumInfluence> weights[],
     const float3 ipoints[], const float3 inormals[], const float4 itangents[],
     float3 opoints[], float3 onormals[], float4 otangents[])
 {
-    parallel_invoke(
-    [&]() {
-        if (ipoints && opoints) {
-            for (int vi = 0; vi < num_vertices; ++vi) {
-                const auto& w = weights[vi];
-                float3 p = ipoints[vi];
-                float3 rp = float3::zero();
-                for (int bi = 0; bi < NumInfluence; ++bi) {
-                    rp += mul_p(poses[w.indices[bi]], p) * w.weights[bi];
-                }
-                opoints[vi] = rp;
-            }
-        }
-    },
-    [&]() {
-        if (inormals && onormals) {
-            for (int vi = 0; vi < num_vertices; ++vi) {
-                const auto& w = weights[vi];
-                float3 n = inormals[vi];
-                float3 rn = float3::zero();
-                for (int bi = 0; bi < NumInfluence; ++bi) {
-                    rn += mul_v(poses[w.indices[bi]], n) * w.weights[bi];
-                }
-                onormals[vi] = normalize(rn);
-            }
-        }
-    },
-    [&]() {
-        if (itangents && otangents) {
-            for (int vi = 0; vi < num_vertices; ++vi) {
-                const auto& w = weights[vi];
-                float4 t = itangents[vi];
-                float4 rt = float4::zero();
-                for (int bi = 0; bi < NumInfluence; ++bi) {
-                    rt += mul_v(poses[w.indices[bi]], t) * w.weights[bi];
-                }
-                otangents[vi] = rt;
-            }
-        }
+    muProfileScope("Skinning", num_vertices);
+    // skin points, normals and tangents together per vertex blocks
+    parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int vi, int vend) {
+        Skinning(poses.cdata(), weights + vi,
+            ipoints ? ipoints + vi : nullptr, inormals ? inormals + vi : nullptr, itangents ? itangents + vi : nullptr,
+            opoints ? opoints + vi : nullptr, onormals ? onormals + vi : nullptr, otangents ? otangents + vi : nullptr,
+            vend - vi);
     });
 }
 
@@ -1489,7 +2000,9 @@ npAPI void npApplySkinning(
     const float3 ipoints[], const float3 inormals[], const float4 itangents[],
     float3 opoints[], float3 onormals[], float4 otangents[])
 {
-    RawVector<float4x4> poses;
+    npProfileScope(skin->num_vertices);
+    ScratchScope scratch;
+    ScratchVector<float4x4> poses;
     poses.resize(skin->num_bones);
 
     auto iroot = invert(skin->root);
@@ -1504,7 +2017,9 @@ npAPI void npApplyReverseSkinning(
     const float3 ipoints[], const float3 inormals[], const float4 itangents[],
     float3 opoints[], float3 onormals[], float4 otangents[])
 {
-    RawVector<float4x4> poses;
+    npProfileScope(skin->num_vertices);
+    ScratchScope scratch;
+    ScratchVector<float4x4> poses;
     poses.resize(skin->num_bones);
 
     auto iroot = invert(skin->root);
@@ -1514,26 +2029,136 @@ npAPI void npApplyReverseSkinning(
     SkinningImpl(skin->num_vertices, poses, skin->weights, ipoints, inormals, itangents, opoints, onormals, otangents);
 }
 
+// reverse skinning of num_sets posed frames at once.
+// bones[si * num_bones + bi] is the bi-th bone matrix of si-th pose set. roots can be null (skin->root is used).
+// ipoints[si] / opoints[si] are points of si-th frame. frames whose buffers are null are skipped.
+npAPI void npApplyReverseSkinningBatch(
+    npSkinData *skin, int num_sets, const float4x4 bones[], const float4x4 roots[],
+    const float3 * const ipoints[], float3 * const opoints[])
+{
+    npProfileScope(skin->num_vertices * num_sets);
+    int num_bones = skin->num_bones;
+    int num_vertices = skin->num_vertices;
+    if (num_sets <= 0 || num_bones <= 0) { return; }
+
+    // invert matrices once per set
+    ScratchScope scratch;
+    ScratchVector<float4x4> poses;
+    poses.resize(num_sets * num_bones);
+    parallel_for(0, num_sets, [&](int si) {
+        auto iroot = invert(roots ? roots[si] : skin->root);
+        auto *set_bones = bones + (size_t)num_bones * si;
+        auto *set_poses = poses.data() + (size_t)num_bones * si;
+        for (int bi = 0; bi < num_bones; ++bi) {
+            set_poses[bi] = invert(skin->bindposes[bi] * set_bones[bi] * iroot);
+        }
+    });
+
+    // weights are read once per vertex for all frames
+    auto weights = skin->weights;
+    parallel_for_blocked(0, num_vertices, npVertexBlockSize, [&](int vi, int vend) {
+        for (; vi < vend; ++vi) {
+            const auto& w = weights[vi];
+            for (int si = 0; si < num_sets; ++si) {
+                if (!ipoints[si] || !opoints[si]) { continue; }
+                auto *set_poses = poses.cdata() + (size_t)num_bones * si;
+                float3 p = ipoints[si][vi];
+                float3 rp = float3::zero();
+                for (int bi = 0; bi < 4; ++bi) {
+                    rp += mul_p(set_poses[w.indices[bi]], p) * w.weights[bi];
+                }
+                opoints[si][vi] = rp;
+            }
+        }
+    });
+}
+
 
 npAPI void npGenerateNormals(npMeshData *model, float3 dst[])
 {
+    npProfileScope(model->num_vertices);
     if (!dst) dst = model->normals;
     if (!dst || !model->vertices || !model->indices) return;
     GenerateNormalsTriangleIndexed(dst, model->vertices, model->indices, model->num_triangles, model->num_vertices);
+    if (dst == model->normals) {
+        MarkDirty(*model, npDirtyNormals);
+    }
 }
 
-npAPI void npGenerateTangents(npMeshData *model, float4 dst[])
+npAPI void npGenerateTangents(npMeshData *model, float4 dst[], npTangentsMode mode)
 {
+    npProfileScope(model->num_vertices);
     if (!dst) dst = model->tangents;
     if (!dst || !model->vertices || !model->uv || !model->normals || !model->indices) return;
-    GenerateTangentsTriangleIndexed(dst,
-        model->vertices, model->uv, model->normals, model->indices, model->num_triangles, model->num_vertices);
+    if (mode == npTangentsMode::MikkTSpace) {
+        GenerateTangentsMikkTSpace(dst,
+            model->vertices, model->uv, model->normals, model->indices, model->num_triangles, model->num_vertices);
+    }
+    else {
+        GenerateTangentsTriangleIndexed(dst,
+            model->vertices, model->uv, model->normals, model->indices, model->num_triangles, model->num_vertices);
+    }
+}
+
+// vertices to update when vertex_indices are modified.
+// vertex_indices is null: use vertices tracked by the context (see npMeshContext::setTrackModified()).
+static void GatherAffectedVertices(const npMeshData& model, const ConnectionData& connection,
+    const int vertex_indices[], int num_vertex_indices, RawVector<int>& dst)
+{
+    RawVector<int> modified;
+    if (!vertex_indices && model.context) {
+        modified.resize_discard(model.context->getModifiedIndices(nullptr));
+        model.context->getModifiedIndices(modified.data());
+        vertex_indices = modified.data();
+        num_vertex_indices = (int)modified.size();
+    }
+    if (!vertex_indices) {
+        dst.clear();
+        return;
+    }
+    GatherAffectedVertices(dst, model.indices, 3, connection, vertex_indices, num_vertex_indices);
+}
+
+// update normals of the faces around the modified vertices only. the adjacency is cached if model has context.
+// returns the number of updated vertices.
+npAPI int npGenerateNormalsPartial(npMeshData *model, const int vertex_indices[], int num_vertex_indices, float3 dst[])
+{
+    npProfileScope(model->num_vertices);
+    if (!dst) dst = model->normals;
+    if (!dst || !model->vertices || !model->indices) return 0;
+
+    ConnectionData connection_tmp;
+    auto& connection = GetConnection(*model, connection_tmp);
+    RawVector<int> affected;
+    GatherAffectedVertices(*model, connection, vertex_indices, num_vertex_indices, affected);
+    GenerateNormalsTriangleIndexedPartial(dst, model->vertices, model->indices, connection,
+        affected.data(), (int)affected.size());
+    if (dst == model->normals && !affected.empty()) {
+        MarkDirty(*model, npDirtyNormals);
+    }
+    return (int)affected.size();
+}
+
+npAPI int npGenerateTangentsPartial(npMeshData *model, const int vertex_indices[], int num_vertex_indices, float4 dst[])
+{
+    npProfileScope(model->num_vertices);
+    if (!dst) dst = model->tangents;
+    if (!dst || !model->vertices || !model->uv || !model->normals || !model->indices) return 0;
+
+    ConnectionData connection_tmp;
+    auto& connection = GetConnection(*model, connection_tmp);
+    RawVector<int> affected;
+    GatherAffectedVertices(*model, connection, vertex_indices, num_vertex_indices, affected);
+    GenerateTangentsTriangleIndexedPartial(dst, model->vertices, model->uv, model->normals, model->indices, connection,
+        affected.data(), (int)affected.size());
+    return (int)affected.size();
 }
 
 npAPI void npGenerateTerrainMesh(
     const float heightmap[], int width, int height, float3 size,
     float3 dst_vertices[], float3 dst_normals[], float2 dst_uv[], int dst_indices[])
 {
+    npProfileScope(width * height);
     int num_vertices = width * height;
     int num_triangles = (width - 1) * (height - 1) * 2;
     auto size_unit = float3{ 1.0f / (width - 1), 1.0f, 1.0f / (height - 1) } *size;
@@ -1552,7 +2177,7 @@ npAPI void npGenerateTerrainMesh(
     [&]() {
         for (int iy = 0; iy < height - 1; ++iy) {
             for (int ix = 0; ix < width - 1; ++ix) {
-                int i6 = (iy * width + ix) * 6;
+                int i6 = (iy * (width - 1) + ix) * 6;
                 dst_indices[i6 + 0] = width*iy + ix;
                 dst_indices[i6 + 1] = width*(iy + 1) + ix;
                 dst_indices[i6 + 2] = width*(iy + 1) + (ix + 1);
@@ -1567,6 +2192,158 @@ npAPI void npGenerateTerrainMesh(
     GenerateNormalsTriangleIndexed(dst_normals, dst_vertices, dst_indices, num_triangles, num_vertices);
 }
 
+// region of the heightmap covered by a chunk of npGenerateTerrainChunk()
+struct TerrainChunk
+{
+    int x0, y0; // first sample
+    int x1, y1; // last sample (inclusive)
+    int step;
+    int nx, ny; // number of vertices in each direction
+
+    bool setup(int width, int height, int tile_size, int lod, int tx, int ty)
+    {
+        if (width < 2 || height < 2 || tile_size < 1 || lod < 0 || lod > 30 || tx < 0 || ty < 0) { return false; }
+        x0 = tx * tile_size;
+        y0 = ty * tile_size;
+        if (x0 >= width - 1 || y0 >= height - 1) { return false; }
+        x1 = std::min(x0 + tile_size, width - 1);
+        y1 = std::min(y0 + tile_size, height - 1);
+        step = std::min(1 << lod, tile_size);
+        // the last row / column is always on the border of the tile to share vertices with neighbors
+        nx = ceildiv(x1 - x0, step) + 1;
+        ny = ceildiv(y1 - y0, step) + 1;
+        return true;
+    }
+
+    int getSampleX(int i) const { return std::min(x0 + i * step, x1); }
+    int getSampleY(int i) const { return std::min(y0 + i * step, y1); }
+    int getNumVertices() const { return nx * ny; }
+    int getNumTriangles() const { return (nx - 1) * (ny - 1) * 2; }
+};
+
+// number of vertices and triangles of a chunk of npGenerateTerrainChunk().
+// returns 0 if the chunk is out of the heightmap or the parameters are invalid, 1 otherwise.
+npAPI int npGetTerrainChunkSize(
+    int width, int height, int tile_size, int lod, int tx, int ty, int *num_vertices, int *num_triangles)
+{
+    TerrainChunk chunk;
+    if (!chunk.setup(width, height, tile_size, lod, tx, ty)) {
+        if (num_vertices) { *num_vertices = 0; }
+        if (num_triangles) { *num_triangles = 0; }
+        return 0;
+    }
+    if (num_vertices) { *num_vertices = chunk.getNumVertices(); }
+    if (num_triangles) { *num_triangles = chunk.getNumTriangles(); }
+    return 1;
+}
+
+// generate a chunk of the mesh of npGenerateTerrainMesh(). the heightmap is split into tiles of tile_size x tile_size
+// quads and (tx, ty) specifies the tile. each lod halves the resolution of the tile.
+// vertices and uv are in the space of the whole terrain, so chunks can be placed as they are.
+// normals are computed from central differences of the heightmap at full resolution. they don't depend on
+// the neighbors of the chunk or lod, so normals on the seams of chunks match.
+// destination buffers must have the sizes given by npGetTerrainChunkSize(). null buffers are skipped.
+// returns the number of vertices (0 if the chunk is invalid).
+npAPI int npGenerateTerrainChunk(
+    const float heightmap[], int width, int height, float3 size, int tile_size, int lod, int tx, int ty,
+    float3 dst_vertices[], float3 dst_normals[], float2 dst_uv[], int dst_indices[])
+{
+    TerrainChunk chunk;
+    if (!chunk.setup(width, height, tile_size, lod, tx, ty)) { return 0; }
+
+    npProfileScope(chunk.getNumVertices());
+    int nx = chunk.nx, ny = chunk.ny;
+    auto size_unit = float3{ 1.0f / (width - 1), 1.0f, 1.0f / (height - 1) } * size;
+    auto uv_unit = float2{ 1.0f / (width - 1), 1.0f / (height - 1) };
+    auto h = [&](int ix, int iy) { return heightmap[iy * width + ix]; };
+
+    parallel_for_blocked(0, ny, 16, [&](int ry, int rend) {
+        for (; ry < rend; ++ry) {
+            int iy = chunk.getSampleY(ry);
+            for (int rx = 0; rx < nx; ++rx) {
+                int ix = chunk.getSampleX(rx);
+                int i = ry * nx + rx;
+                if (dst_vertices) {
+                    dst_vertices[i] = float3{ (float)ix, h(ix, iy), (float)iy } * size_unit;
+                }
+                if (dst_uv) {
+                    dst_uv[i] = float2{ (float)ix, (float)iy } * uv_unit;
+                }
+                if (dst_normals) {
+                    int xl = std::max(ix - 1, 0), xr = std::min(ix + 1, width - 1);
+                    int yl = std::max(iy - 1, 0), yr = std::min(iy + 1, height - 1);
+                    float dx = (h(xr, iy) - h(xl, iy)) * size_unit.y / ((xr - xl) * size_unit.x);
+                    float dz = (h(ix, yr) - h(ix, yl)) * size_unit.y / ((yr - yl) * size_unit.z);
+                    dst_normals[i] = normalize(float3{ -dx, 1.0f, -dz });
+                }
+            }
+        }
+    });
+
+    if (dst_indices) {
+        // same topology as npGenerateTerrainMesh()
+        parallel_for_blocked(0, ny - 1, 16, [&](int ry, int rend) {
+            for (; ry < rend; ++ry) {
+                for (int rx = 0; rx < nx - 1; ++rx) {
+                    int i6 = (ry * (nx - 1) + rx) * 6;
+                    dst_indices[i6 + 0] = nx*ry + rx;
+                    dst_indices[i6 + 1] = nx*(ry + 1) + rx;
+                    dst_indices[i6 + 2] = nx*(ry + 1) + (rx + 1);
+
+                    dst_indices[i6 + 3] = nx*ry + rx;
+                    dst_indices[i6 + 4] = nx*(ry + 1) + (rx + 1);
+                    dst_indices[i6 + 5] = nx*ry + (rx + 1);
+                }
+            }
+        });
+    }
+    return nx * ny;
+}
+
+
+
+// dst (optional) receives stats of profiling counters. returns the number of counters.
+// always returns 0 if the plugin is built without muEnableProfile.
+npAPI int npGetProfileStats(npProfileStats *dst, int max_stats)
+{
+#ifdef muEnableProfile
+    int n = ProfileGetStats(nullptr, 0);
+    if (!dst) { return n; }
+
+    std::vector<ProfileStats> stats(std::max<int>(std::min<int>(n, max_stats), 0));
+    n = ProfileGetStats(stats.data(), (int)stats.size());
+    for (int i = 0; i < n; ++i) {
+        auto& s = stats[i];
+        auto& d = dst[i];
+        d.name = s.name;
+        d.num_calls = (int64_t)s.num_calls;
+        d.num_elements = (int64_t)s.num_elements;
+        d.total_ms = NS2MS(s.total_time);
+        d.max_ms = NS2MS(s.max_time);
+        d.elements_per_sec = s.total_time > 0 ? (double)s.num_elements / ((double)s.total_time / 1e9) : 0.0;
+    }
+    return n;
+#else
+    (void)dst; (void)max_stats;
+    return 0;
+#endif
+}
+
+npAPI void npResetProfileStats()
+{
+#ifdef muEnableProfile
+    ProfileReset();
+#endif
+}
+
+// returns the name of the instruction set ISPC kernels are dispatched to on this CPU (e.g. "avx2").
+// "generic" if the plugin is built without ISPC. width (optional) receives the number of SIMD lanes of it.
+npAPI const char* npGetSIMDTarget(int *width)
+{
+    if (width) { *width = GetSIMDWidth(); }
+    return GetSIMDTargetName(GetSIMDTarget());
+}
+
 
 float g_pen_pressure = 1.0f;
 
@@ -9,3 +9,78 @@
 
 #include "MeshUtils/MeshUtils.h"
 using namespace mu;
+
+#define npVertexBlockSize 1024
+#define npDepthBufferSize 512
+
+// values of frontface_only argument of selection functions
+enum npVisibilityMode
+{
+    npVisibilityAll         = 0,
+    npVisibilityRaycast     = 1, // cast a ray toward each vertex
+    npVisibilityDepthBuffer = 2, // rasterize the mesh into a low resolution depth buffer and compare depth
+};
+
+struct npMeshContext;
+
+enum class npProjectVerticesMode
+{
+    Forward,
+    Backward,
+    ForwardAndBackward,
+};
+
+// algorithm of npGenerateTangents()
+enum class npTangentsMode
+{
+    Fast,       // per-vertex accumulation
+    MikkTSpace, // compatible with mikktspace (baked normal maps). slower.
+};
+
+// algorithm of npBrushSmooth()
+enum class npSmoothMode
+{
+    Average,   // blend toward the average of all vertices in the dab
+    Laplacian, // blend toward the average of one-ring neighbors. more local. topology is cached only if the model has a context.
+};
+
+struct npMeshData
+{
+    int         *indices = nullptr;
+    float3      *vertices = nullptr;
+    float3      *normals = nullptr;
+    float4      *tangents = nullptr;
+    float2      *uv = nullptr;
+    float       *selection = nullptr;
+    int         num_vertices = 0;
+    int         num_triangles = 0;
+    float4x4    transform = float4x4::identity();
+    npMeshContext *context = nullptr; // optional. see npMeshContext.h
+};
+
+struct npSkinData
+{
+    Weights4    *weights = nullptr;
+    float4x4    *bones = nullptr;
+    float4x4    *bindposes = nullptr;
+    int         num_vertices = 0;
+    int         num_bones = 0;
+    float4x4    root = float4x4::identity();
+};
+
+// see npGetProfileStats()
+struct npProfileStats
+{
+    const char  *name = nullptr;
+    int64_t     num_calls = 0;
+    int64_t     num_elements = 0; // usually vertices
+    double      total_ms = 0.0;
+    double      max_ms = 0.0;
+    double      elements_per_sec = 0.0;
+};
+
+// measures the calling function. see muProfileScope().
+#define npProfileScope(NumElements) muProfileScope(__FUNCTION__, NumElements)
+
+#include "npMeshContext.h"
+#include "npJob.h"
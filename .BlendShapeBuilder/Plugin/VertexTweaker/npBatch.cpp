@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "VertexTweaker.h"
+
+// batch versions of per-mesh entry points. typically used to process all meshes that share a vertex count
+// (LODs, outfit variants, etc.) in one call. meshes are processed in parallel and each of them is processed
+// by the parallelized single-mesh function, so big and small meshes balance on the thread pool.
+// meshes in a batch must not share buffers or contexts.
+
+// defined in VertexTweaker.cpp
+npAPI void npProjectVertices(
+    npMeshData *model, npMeshData *target, const float3 ray_dirs[], npProjectVerticesMode mode, float max_distance, int PNT, int mask);
+npAPI void npApplySkinning(
+    npSkinData *skin,
+    const float3 ipoints[], const float3 inormals[], const float4 itangents[],
+    float3 opoints[], float3 onormals[], float4 otangents[]);
+npAPI void npGenerateNormals(npMeshData *model, float3 dst[]);
+npAPI void npGenerateTangents(npMeshData *model, float4 dst[], npTangentsMode mode);
+
+// calls body(i) for each of num items. larger items are started first to shorten the tail.
+template<class GetSize, class Body>
+static void BatchFor(int num, const GetSize& get_size, const Body& body)
+{
+    if (num <= 0) { return; }
+
+    RawVector<int> order;
+    order.resize_discard(num);
+    for (int i = 0; i < num; ++i) { order[i] = i; }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return get_size(a) > get_size(b); });
+    parallel_for(0, num, [&](int i) { body(order[i]); });
+}
+
+template<class T>
+static inline T* GetEntry(T * const *arrays, int i)
+{
+    return arrays ? arrays[i] : nullptr;
+}
+
+
+// ray_dirs[i] is the ray directions of models[i]. normals of the model are used if ray_dirs or ray_dirs[i] is null.
+// the BVH of target is built once for the batch (or taken from its context).
+npAPI void npProjectVerticesBatch(
+    npMeshData models[], int num_models, npMeshData *target, const float3 * const ray_dirs[],
+    npProjectVerticesMode mode, float max_distance, int PNT, int mask)
+{
+    npProfileScope(num_models);
+    if (!models || !target || num_models <= 0) { return; }
+
+    // the context is only read by the models' threads once the BVH is built
+    npMeshContext ctx_tmp;
+    npMeshData tdata = *target;
+    if (!tdata.context) { tdata.context = &ctx_tmp; }
+    tdata.context->getBVH(tdata);
+
+    BatchFor(num_models,
+        [&](int i) { return models[i].num_vertices; },
+        [&](int i) {
+            auto dirs = GetEntry(ray_dirs, i);
+            if (!dirs) { dirs = models[i].normals; }
+            if (!dirs) { return; }
+            npProjectVertices(&models[i], &tdata, dirs, mode, max_distance, PNT, mask);
+        });
+}
+
+// i*[i] and o*[i] are the buffers of skins[i]. null arrays or entries are skipped as npApplySkinning() does.
+npAPI void npApplySkinningBatch(
+    npSkinData skins[], int num_skins,
+    const float3 * const ipoints[], const float3 * const inormals[], const float4 * const itangents[],
+    float3 * const opoints[], float3 * const onormals[], float4 * const otangents[])
+{
+    npProfileScope(num_skins);
+    if (!skins) { return; }
+
+    BatchFor(num_skins,
+        [&](int i) { return skins[i].num_vertices; },
+        [&](int i) {
+            npApplySkinning(&skins[i],
+                GetEntry(ipoints, i), GetEntry(inormals, i), GetEntry(itangents, i),
+                GetEntry(opoints, i), GetEntry(onormals, i), GetEntry(otangents, i));
+        });
+}
+
+// dst[i] receives normals of models[i]. models[i].normals is used if dst or dst[i] is null.
+npAPI void npGenerateNormalsBatch(npMeshData models[], int num_models, float3 * const dst[])
+{
+    npProfileScope(num_models);
+    if (!models) { return; }
+
+    BatchFor(num_models,
+        [&](int i) { return models[i].num_triangles; },
+        [&](int i) { npGenerateNormals(&models[i], GetEntry(dst, i)); });
+}
+
+// dst[i] receives tangents of models[i]. models[i].tangents is used if dst or dst[i] is null.
+npAPI void npGenerateTangentsBatch(npMeshData models[], int num_models, float4 * const dst[], npTangentsMode mode)
+{
+    npProfileScope(num_models);
+    if (!models) { return; }
+
+    BatchFor(num_models,
+        [&](int i) { return models[i].num_triangles; },
+        [&](int i) { npGenerateTangents(&models[i], GetEntry(dst, i), mode); });
+}
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "VertexTweaker.h"
+
+// generate deltas of num_frames blend shape frames at once.
+// vertices[fi] etc. are the buffers of frame fi and dst_*[fi] receive the deltas from base_*.
+// if a source buffer is null, corresponding destination is zero cleared. null destination arrays are ignored.
+// returns 0 if the current job is cancelled. some of the deltas may be written in that case.
+npAPI int npGenerateBlendShapeDeltas(
+    int num_vertices, int num_frames,
+    const float3 *base_vertices, const float3 *base_normals, const float4 *base_tangents,
+    const float3 * const *vertices, const float3 * const *normals, const float4 * const *tangents,
+    float3 * const *dst_vertices, float3 * const *dst_normals, float3 * const *dst_tangents)
+{
+    npProfileScope(num_vertices * num_frames);
+    if (num_vertices <= 0 || num_frames <= 0) { return 0; }
+
+    int num_blocks = ceildiv(num_vertices, npVertexBlockSize);
+    bool completed = JobParallelForBlocked(npJob::getCurrent(), 0, num_frames * num_blocks, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            int fi = i / num_blocks;
+            int vi = (i % num_blocks) * npVertexBlockSize;
+            int n = std::min<int>(num_vertices - vi, npVertexBlockSize);
+
+            auto delta3 = [&](const float3 *base, const float3 * const *src, float3 * const *dst) {
+                if (!dst || !dst[fi]) { return; }
+                if (base && src && src[fi])
+                    GenerateDelta(dst[fi] + vi, base + vi, src[fi] + vi, n);
+                else
+                    memset(dst[fi] + vi, 0, sizeof(float3) * n);
+            };
+            delta3(base_vertices, vertices, dst_vertices);
+            delta3(base_normals, normals, dst_normals);
+
+            if (dst_tangents && dst_tangents[fi]) {
+                if (base_tangents && tangents && tangents[fi])
+                    GenerateDelta(dst_tangents[fi] + vi, base_tangents + vi, tangents[fi] + vi, n);
+                else
+                    memset(dst_tangents[fi] + vi, 0, sizeof(float3) * n);
+            }
+        }
+    });
+    return completed ? num_frames : 0;
+}
+
+
+// sparse deltas. null channels are omitted.
+npAPI SparseDelta* npCreateSparseDelta(
+    int num_vertices, const float3 *points, const float3 *normals, const float3 *tangents, float eps)
+{
+    npProfileScope(num_vertices);
+    auto ret = new SparseDelta();
+    ret->fromDense(points, normals, tangents, num_vertices, eps);
+    return ret;
+}
+
+npAPI void npReleaseSparseDelta(SparseDelta *sd)
+{
+    delete sd;
+}
+
+// number of moved vertices
+npAPI int npSparseDeltaGetSize(const SparseDelta *sd)
+{
+    return sd ? sd->size() : 0;
+}
+
+template<class T>
+static inline void CopyIfPresent(T *dst, const RawVector<T>& src)
+{
+    if (dst && !src.empty()) {
+        memcpy(dst, src.cdata(), sizeof(T) * src.size());
+    }
+}
+
+// copy packed data. buffers must have npSparseDeltaGetSize() elements. null buffers are ignored.
+npAPI void npSparseDeltaGetData(const SparseDelta *sd, int *indices, float3 *points, float3 *normals, float3 *tangents)
+{
+    if (!sd) { return; }
+    CopyIfPresent(indices, sd->indices);
+    CopyIfPresent(points, sd->points);
+    CopyIfPresent(normals, sd->normals);
+    CopyIfPresent(tangents, sd->tangents);
+}
+
+// dst_* must have num_vertices elements. null buffers are ignored.
+npAPI void npSparseDeltaToDense(const SparseDelta *sd, float3 *points, float3 *normals, float3 *tangents)
+{
+    if (!sd) { return; }
+    sd->toDense(points, normals, tangents);
+}
+
+
+// blend shapes for evaluation. each frame is stored as SparseDelta.
+npAPI SparseBlendShape* npCreateBlendShape()
+{
+    return new SparseBlendShape();
+}
+
+npAPI void npReleaseBlendShape(SparseBlendShape *bs)
+{
+    delete bs;
+}
+
+// frames can be added in any order. null channels are omitted.
+npAPI void npBlendShapeAddFrame(SparseBlendShape *bs, float weight,
+    int num_vertices, const float3 *points, const float3 *normals, const float3 *tangents, float eps)
+{
+    npProfileScope(num_vertices);
+    if (!bs) { return; }
+    bs->addFrame(weight).fromDense(points, normals, tangents, num_vertices, eps);
+}
+
+// dst = base + sum of shapes[i] at weights[i]. base is vertices, normals and tangents of model.
+npAPI void npEvaluateBlendShapes(npMeshData *base,
+    SparseBlendShape * const *shapes, const float *weights, int num_shapes,
+    float3 *dst_points, float3 *dst_normals, float4 *dst_tangents)
+{
+    npProfileScope(base->num_vertices);
+    EvaluateBlendShapes(dst_points, dst_normals, dst_tangents,
+        base->vertices, base->normals, base->tangents, base->num_vertices,
+        shapes, weights, num_shapes);
+}
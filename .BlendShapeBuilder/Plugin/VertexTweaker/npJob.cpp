@@ -0,0 +1,259 @@
+#include "pch.h"
+#include "VertexTweaker.h"
+
+// defined in VertexTweaker.cpp and npBlendShape.cpp
+npAPI void npProjectVertices(
+    npMeshData *model, npMeshData *target, const float3 ray_dirs[], npProjectVerticesMode mode, float max_distance, int PNT, int mask);
+npAPI int npWeld2(
+    npMeshData *model, int num_targets, npMeshData targets[],
+    int weld_mode, float weld_angle, int mask);
+npAPI int npBuildMirroringRelation(
+    npMeshData *model, float3 mirror_plane, float epsilon, int relation[]);
+npAPI int npGenerateBlendShapeDeltas(
+    int num_vertices, int num_frames,
+    const float3 *base_vertices, const float3 *base_normals, const float4 *base_tangents,
+    const float3 * const *vertices, const float3 * const *normals, const float4 * const *tangents,
+    float3 * const *dst_vertices, float3 * const *dst_normals, float3 * const *dst_tangents);
+
+static thread_local npJob *g_current_job = nullptr;
+
+npJob* npJob::getCurrent()
+{
+    return g_current_job;
+}
+
+npJob::npJob(const std::function<int()>& body)
+    : m_body(body)
+{
+}
+
+npJob::~npJob()
+{
+}
+
+void npJob::addWork(int64_t n)
+{
+    m_total += n;
+}
+
+void npJob::advance(int64_t n)
+{
+    m_done += n;
+}
+
+float npJob::getProgress() const
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_state != npJobState::Running) { return 1.0f; }
+    }
+    int64_t total = m_total;
+    if (total <= 0) { return 0.0f; }
+    return std::min<float>((float)((double)m_done / (double)total), 1.0f);
+}
+
+void npJob::cancel()
+{
+    m_canceled = true;
+}
+
+bool npJob::isCanceled() const
+{
+    return m_canceled;
+}
+
+bool npJob::checkCanceled()
+{
+    if (!m_canceled) { return false; }
+    m_stopped = true;
+    return true;
+}
+
+npJobState npJob::wait(int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto done = [this]() { return m_state != npJobState::Running; };
+    if (timeout_ms < 0)
+        m_cond.wait(lock, done);
+    else
+        m_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), done);
+    return m_state;
+}
+
+int npJob::getResult() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_result;
+}
+
+void npJob::run()
+{
+    // jobs cancelled while waiting in the queue are not run at all
+    int result = 0;
+    if (m_canceled) {
+        m_stopped = true;
+    }
+    else {
+        g_current_job = this;
+        result = m_body();
+        g_current_job = nullptr;
+    }
+
+    // notify while locked: the job can be deleted by the waiter as soon as the lock is released
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_result = result;
+    m_state = m_stopped ? npJobState::Canceled : npJobState::Completed;
+    m_cond.notify_all();
+}
+
+
+namespace {
+
+// runs jobs one by one in FIFO order on a persistent thread.
+// running them concurrently wouldn't be faster as operations are parallelized internally, and would require
+// callers to care about jobs sharing meshes. it also bounds the per-thread scratch memory (see ScratchArena).
+class npJobQueue
+{
+public:
+    static npJobQueue& getInstance()
+    {
+        static npJobQueue s_instance;
+        return s_instance;
+    }
+
+    void push(npJob *job)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            m_thread = std::thread([this]() { process(); });
+        }
+        m_jobs.push_back(job);
+        m_cond.notify_one();
+    }
+
+private:
+    npJobQueue() {}
+
+    ~npJobQueue()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+            for (auto job : m_jobs) { job->cancel(); }
+            m_cond.notify_one();
+        }
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void process()
+    {
+        for (;;) {
+            npJob *job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+                if (m_jobs.empty()) { break; }
+                job = m_jobs.front();
+                m_jobs.pop_front();
+            }
+            job->run();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<npJob*> m_jobs;
+    std::thread m_thread;
+    bool m_stop = false;
+};
+
+} // namespace
+
+
+// starts the operation of kind on the background. args points to the corresponding npJobKind's arguments.
+// returns null if kind is unknown. the job must be released by npJobRelease().
+npAPI npJob* npJobStart(npJobKind kind, const void *args)
+{
+    if (!args) { return nullptr; }
+
+    std::function<int()> body;
+    switch (kind) {
+    case npJobKind::ProjectVertices:
+    {
+        auto a = *(const npProjectVerticesArgs*)args;
+        body = [a]() {
+            npProjectVertices(a.model, a.target, a.ray_dirs, a.mode, a.max_distance, a.PNT, a.mask);
+            return 0;
+        };
+        break;
+    }
+    case npJobKind::Weld2:
+    {
+        auto a = *(const npWeld2Args*)args;
+        body = [a]() {
+            return npWeld2(a.model, a.num_targets, a.targets, a.weld_mode, a.weld_angle, a.mask);
+        };
+        break;
+    }
+    case npJobKind::BuildMirroringRelation:
+    {
+        auto a = *(const npBuildMirroringRelationArgs*)args;
+        body = [a]() {
+            return npBuildMirroringRelation(a.model, a.mirror_plane, a.epsilon, a.relation);
+        };
+        break;
+    }
+    case npJobKind::GenerateBlendShapeDeltas:
+    {
+        auto a = *(const npGenerateBlendShapeDeltasArgs*)args;
+        body = [a]() {
+            return npGenerateBlendShapeDeltas(a.num_vertices, a.num_frames,
+                a.base_vertices, a.base_normals, a.base_tangents,
+                a.vertices, a.normals, a.tangents,
+                a.dst_vertices, a.dst_normals, a.dst_tangents);
+        };
+        break;
+    }
+    default:
+        return nullptr;
+    }
+
+    auto job = new npJob(body);
+    npJobQueue::getInstance().push(job);
+    return job;
+}
+
+// 0-1. 1 once the job is finished (completed or cancelled).
+npAPI float npJobProgress(npJob *job)
+{
+    return job ? job->getProgress() : 0.0f;
+}
+
+// requests cancellation. the job stops at the next check point of the operation.
+npAPI void npJobCancel(npJob *job)
+{
+    if (job) { job->cancel(); }
+}
+
+// waits up to timeout_ms (infinite if negative). returns npJobState.
+npAPI int npJobWait(npJob *job, int timeout_ms)
+{
+    return job ? (int)job->wait(timeout_ms) : (int)npJobState::Canceled;
+}
+
+// return value of the operation (e.g. number of pairs of npBuildMirroringRelation()). 0 if not completed yet.
+npAPI int npJobGetResult(npJob *job)
+{
+    return job ? job->getResult() : 0;
+}
+
+// cancels the job if it is running, waits for it and deletes it.
+npAPI void npJobRelease(npJob *job)
+{
+    if (!job) { return; }
+    job->cancel();
+    job->wait(-1);
+    delete job;
+}
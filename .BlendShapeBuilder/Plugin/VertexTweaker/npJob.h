@@ -0,0 +1,136 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+
+// asynchronous execution of long operations (see npJobStart()).
+// jobs are run one at a time in the order of npJobStart() on a background thread. operations use the thread pool
+// as usual. meshes given to a job (and their contexts) must not be used by others until the job finishes.
+
+enum class npJobKind
+{
+    ProjectVertices,          // args: npProjectVerticesArgs
+    Weld2,                    // args: npWeld2Args
+    BuildMirroringRelation,   // args: npBuildMirroringRelationArgs
+    GenerateBlendShapeDeltas, // args: npGenerateBlendShapeDeltasArgs
+};
+
+enum class npJobState
+{
+    Running,    // including waiting for preceding jobs
+    Completed,
+    Canceled,   // stopped by cancellation before or while running. results may be missing or partial.
+};
+
+// arguments of the corresponding entry points. copied by npJobStart(), but the buffers they point to are not.
+struct npProjectVerticesArgs
+{
+    npMeshData *model;
+    npMeshData *target;
+    const float3 *ray_dirs;
+    npProjectVerticesMode mode;
+    float max_distance;
+    int PNT;
+    int mask;
+};
+
+struct npWeld2Args
+{
+    npMeshData *model;
+    int num_targets;
+    npMeshData *targets;
+    int weld_mode;
+    float weld_angle;
+    int mask;
+};
+
+struct npBuildMirroringRelationArgs
+{
+    npMeshData *model;
+    float3 mirror_plane;
+    float epsilon;
+    int *relation;
+};
+
+struct npGenerateBlendShapeDeltasArgs
+{
+    int num_vertices;
+    int num_frames;
+    const float3 *base_vertices;
+    const float3 *base_normals;
+    const float4 *base_tangents;
+    const float3 * const *vertices;
+    const float3 * const *normals;
+    const float4 * const *tangents;
+    float3 * const *dst_vertices;
+    float3 * const *dst_normals;
+    float3 * const *dst_tangents;
+};
+
+
+// operations get the job running them by getCurrent() (null outside jobs), report progress and check cancellation
+// between blocks of work. cancelled operations should stop as soon as possible and leave results untouched if they can.
+class npJob
+{
+public:
+    static npJob* getCurrent();
+
+    explicit npJob(const std::function<int()>& body);
+    ~npJob();
+
+    // progress is the ratio of advanced work to added work. thread safe.
+    void addWork(int64_t n);
+    void advance(int64_t n);
+    float getProgress() const;
+
+    void cancel();
+    bool isCanceled() const;
+    // cancellation point. same as isCanceled(), but true also records that the operation stops early.
+    // the job is reported as Completed if cancel() is called after the last cancellation point. thread safe.
+    bool checkCanceled();
+
+    // waits for the job up to timeout_ms (infinite if negative) and returns the state.
+    npJobState wait(int timeout_ms);
+    // return value of the operation. valid after the job is completed.
+    int getResult() const;
+
+    // called by the job queue
+    void run();
+
+private:
+    npJob(const npJob&) = delete;
+    npJob& operator=(const npJob&) = delete;
+
+    std::function<int()> m_body;
+    std::atomic<int64_t> m_total{ 0 };
+    std::atomic<int64_t> m_done{ 0 };
+    std::atomic_bool m_canceled{ false };
+    std::atomic_bool m_stopped{ false };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    npJobState m_state = npJobState::Running;
+    int m_result = 0;
+};
+
+// parallel_for_blocked() that reports end - begin of work to job and checks cancellation between rounds of blocks.
+// job can be null. returns false if the job has been cancelled before all blocks are processed. remaining blocks are skipped in that case.
+template<class Body>
+inline bool JobParallelForBlocked(npJob *job, int begin, int end, int granularity, const Body& body)
+{
+    if (!job) {
+        parallel_for_blocked(begin, end, granularity, body);
+        return true;
+    }
+
+    job->addWork(end - begin);
+    const int blocks_per_round = 64;
+    int round = granularity * blocks_per_round;
+    for (int rb = begin; rb < end; rb += round) {
+        if (job->checkCanceled()) { return false; }
+        int re = std::min<int>(rb + round, end);
+        parallel_for_blocked(rb, re, granularity, body);
+        job->advance(re - rb);
+    }
+    return true;
+}
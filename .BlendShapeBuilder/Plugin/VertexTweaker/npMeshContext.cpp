@@ -0,0 +1,533 @@
+#include "pch.h"
+#include "VertexTweaker.h"
+
+static void TransformVertices(float3 *dst, const npMeshData& mesh, const float4x4& trans)
+{
+    auto vertices = mesh.vertices;
+    parallel_for_blocked(0, mesh.num_vertices, 4096, [&](int begin, int end) {
+        MulPoints(trans, vertices + begin, dst + begin, end - begin);
+    });
+}
+
+static void FlattenTriangles(RawVector<float> (&soa)[9], const npMeshData& mesh, const float4x4& trans)
+{
+    muProfileScope("FlattenTriangles", mesh.num_triangles);
+    auto vertices = mesh.vertices;
+    auto indices = mesh.indices;
+    int num_triangles = mesh.num_triangles;
+    for (int i = 0; i < 9; ++i) {
+        soa[i].resize(num_triangles);
+    }
+    parallel_for_blocked(0, num_triangles, 4096, [&](int begin, int end) {
+        for (int ti = begin; ti < end; ++ti) {
+            for (int i = 0; i < 3; ++i) {
+                auto p = mul_p(trans, vertices[indices[ti * 3 + i]]);
+                soa[i * 3 + 0][ti] = p.x;
+                soa[i * 3 + 1][ti] = p.y;
+                soa[i * 3 + 2][ti] = p.z;
+            }
+        }
+    });
+}
+
+void npProjectedVertices::build(const npMeshData& mesh, const float4x4& mvp)
+{
+    int num_vertices = mesh.num_vertices;
+    auto vertices = mesh.vertices;
+    x.resize_discard(num_vertices);
+    y.resize_discard(num_vertices);
+    z.resize_discard(num_vertices);
+    w.resize_discard(num_vertices);
+    parallel_for_blocked(0, num_vertices, 4096, [&](int begin, int end) {
+        ProjectPoints(mvp, vertices + begin, &x[begin], &y[begin], &z[begin], &w[begin], end - begin);
+    });
+    grid.build(x.data(), y.data(), num_vertices, float2{ -1.0f, -1.0f }, float2{ 1.0f, 1.0f });
+}
+
+void npVerticesSoA::build(const npMeshData& mesh)
+{
+    int num_vertices = mesh.num_vertices;
+    auto vertices = mesh.vertices;
+    x.resize_discard(num_vertices);
+    y.resize_discard(num_vertices);
+    z.resize_discard(num_vertices);
+    parallel_for_blocked(0, num_vertices, 4096, [&](int begin, int end) {
+        Deinterleave(&x[begin], &y[begin], &z[begin], vertices + begin, end - begin);
+    });
+}
+
+static void BuildConnection(ConnectionData& dst, const npMeshData& mesh, bool welding = false)
+{
+    dst.buildConnection(
+        IArray<int>(mesh.indices, mesh.num_triangles * 3), 3,
+        IArray<float3>(mesh.vertices, mesh.num_vertices), welding);
+}
+
+// relation[vi]: index of the vertex mirrored from vi, -2 if vi is on the mirror plane, -1 otherwise.
+// returns number of mirrored pairs, or -1 if the current job is cancelled (relation is incomplete in that case).
+static int BuildMirroringRelation(int *relation, const npMeshData& mesh, const float3& plane, float epsilon)
+{
+    auto num_vertices = mesh.num_vertices;
+    auto vertices = mesh.vertices;
+    auto normals = mesh.normals;
+
+    RawVector<float> distances;
+    distances.resize(num_vertices);
+    parallel_for(0, num_vertices, [&](int vi) {
+        distances[vi] = plane_distance(vertices[vi], plane);
+    });
+
+    // index reflected vertices on the positive side
+    RawVector<int> sources;
+    RawVector<float3> reflected;
+    for (int i = 0; i < num_vertices; ++i) {
+        float d = distances[i];
+        if (d > 0.0f) {
+            sources.push_back(i);
+            reflected.push_back(vertices[i] - plane * (d * 2.0f));
+        }
+    }
+    SpatialHashGrid grid;
+    if (epsilon > 0.0f) {
+        grid.build(reflected.data(), (int)reflected.size(), epsilon);
+    }
+
+    std::atomic_int ret{ 0 };
+    bool completed = JobParallelForBlocked(npJob::getCurrent(), 0, num_vertices, npVertexBlockSize, [&](int begin, int end) {
+        for (int vi = begin; vi < end; ++vi) {
+            int rel = -1;
+            float d1 = distances[vi];
+            if (d1 < 0.0f) {
+                // pick the smallest index among matches
+                float3 p = vertices[vi];
+                float3 n1 = normals[vi];
+                grid.eachPointsInSphere(p, epsilon, [&](int ri) {
+                    int i = sources[ri];
+                    if ((rel == -1 || i < rel) &&
+                        length(p - reflected[ri]) < epsilon &&
+                        dot(n1, plane_mirror(normals[i], plane)) >= 0.99f)
+                    {
+                        rel = i;
+                    }
+                });
+                if (rel != -1) { ++ret; }
+            }
+            else if (near_equal(d1, 0.0f)) {
+                rel = -2; // -2: on mirror plane
+            }
+            relation[vi] = rel;
+        }
+    });
+    return completed ? (int)ret : -1;
+}
+
+
+void npMeshContext::markDirty(int flags, bool tracked)
+{
+    if (flags & npDirtyVertices) {
+        ++m_vertex_version;
+        if (!tracked) { m_grid.untracked = true; }
+    }
+    if (flags & npDirtyIndices) { ++m_index_version; }
+    if (flags & npDirtyNormals) { ++m_normal_version; }
+}
+
+npMeshContext::SourceKey npMeshContext::makeKey(const npMeshData& mesh, int flags) const
+{
+    SourceKey ret;
+    if (flags & npDirtyVertices) {
+        ret.vertices = mesh.vertices;
+        ret.num_vertices = mesh.num_vertices;
+        ret.vertex_version = m_vertex_version;
+    }
+    if (flags & npDirtyIndices) {
+        ret.indices = mesh.indices;
+        ret.num_triangles = mesh.num_triangles;
+        ret.index_version = m_index_version;
+    }
+    if (flags & npDirtyNormals) {
+        ret.normals = mesh.normals;
+        ret.normal_version = m_normal_version;
+    }
+    return ret;
+}
+
+const float3* npMeshContext::getTransformedVertices(const npMeshData& mesh, const float4x4& trans)
+{
+    auto key = makeKey(mesh, npDirtyVertices);
+    ++m_tick;
+
+    TransformedVertices *slot = nullptr;
+    for (auto& t : m_transformed) {
+        if (t.key == key && t.trans == trans) {
+            slot = &t;
+            break;
+        }
+    }
+    if (!slot) {
+        // replace least recently used one
+        slot = &m_transformed[0];
+        for (auto& t : m_transformed) {
+            if (t.last_used < slot->last_used) { slot = &t; }
+        }
+        slot->key = key;
+        slot->trans = trans;
+        slot->data.resize_discard(mesh.num_vertices);
+        TransformVertices(slot->data.data(), mesh, trans);
+    }
+    slot->last_used = m_tick;
+    return slot->data.data();
+}
+
+const RawVector<float>* npMeshContext::getFlattenedTriangles(const npMeshData& mesh, const float4x4& trans)
+{
+    auto key = makeKey(mesh, npDirtyVertices | npDirtyIndices);
+    auto& f = m_flattened;
+    if (f.key != key || f.trans != trans) {
+        f.key = key;
+        f.trans = trans;
+        FlattenTriangles(f.soa, mesh, trans);
+    }
+    return f.soa;
+}
+
+const TriangleBVH& npMeshContext::getBVH(const npMeshData& mesh)
+{
+    auto key = makeKey(mesh, npDirtyVertices | npDirtyIndices);
+    auto& b = m_bvh;
+    if (b.key != key) {
+        b.key = key;
+        b.bvh.build(mesh.vertices, mesh.indices, mesh.num_triangles);
+    }
+    return b.bvh;
+}
+
+npVerticesSoA& npMeshContext::getVerticesSoA(const npMeshData& mesh)
+{
+    auto key = makeKey(mesh, npDirtyVertices);
+    auto& s = m_soa;
+    if (s.key != key) {
+        s.data.build(mesh);
+        s.key = key;
+    }
+    return s.data;
+}
+
+void npMeshContext::validateVerticesSoA(const npMeshData& mesh)
+{
+    m_soa.key = makeKey(mesh, npDirtyVertices);
+}
+
+const SpatialHashGrid& npMeshContext::getVertexGrid(const npMeshData& mesh)
+{
+    auto key = makeKey(mesh, npDirtyVertices);
+    auto& g = m_grid;
+    if (g.key != key) {
+        if (g.key.vertices == key.vertices && g.key.num_vertices == key.num_vertices) {
+            // same buffer. relocate only vertices that moved to other cells.
+            if (!g.untracked && (int)m_modified.size() == ceildiv(mesh.num_vertices, 32)) {
+                // only vertices modified by the native API need to be examined
+                const uint32_t *bits = m_modified.data();
+                if (g.has_pending) {
+                    for (size_t wi = 0; wi < m_modified.size(); ++wi) {
+                        g.pending[wi] |= m_modified[wi];
+                    }
+                    bits = g.pending.data();
+                }
+                g.grid.update(mesh.vertices, bits);
+            }
+            else {
+                g.grid.update(mesh.vertices);
+            }
+        }
+        else {
+            g.grid.build(mesh.vertices, mesh.num_vertices);
+        }
+        g.key = key;
+        g.untracked = false;
+        g.has_pending = false;
+    }
+    return g.grid;
+}
+
+const ConnectionData& npMeshContext::getConnection(const npMeshData& mesh)
+{
+    auto key = makeKey(mesh, npDirtyIndices);
+    auto& c = m_connection;
+    if (c.key != key || c.num_vertices != mesh.num_vertices) {
+        BuildConnection(c.connection, mesh);
+        c.key = key;
+        c.num_vertices = mesh.num_vertices;
+    }
+    return c.connection;
+}
+
+const ConnectionData& npMeshContext::getWeldedConnection(const npMeshData& mesh)
+{
+    // welding depends on positions
+    auto key = makeKey(mesh, npDirtyVertices | npDirtyIndices);
+    auto& c = m_welded_connection;
+    if (c.key != key || c.num_vertices != mesh.num_vertices) {
+        BuildConnection(c.connection, mesh, true);
+        c.key = key;
+        c.num_vertices = mesh.num_vertices;
+    }
+    return c.connection;
+}
+
+const npProjectedVertices& npMeshContext::getProjectedVertices(const npMeshData& mesh, const float4x4& mvp)
+{
+    auto key = makeKey(mesh, npDirtyVertices);
+    auto& p = m_projected;
+    if (p.key != key || p.mvp != mvp) {
+        p.data.build(mesh, mvp);
+        p.key = key;
+        p.mvp = mvp;
+    }
+    return p.data;
+}
+
+const int* npMeshContext::getMirroringRelation(const npMeshData& mesh, const float3& plane, float epsilon, int& num_pairs)
+{
+    // pairs are tested by normals too
+    auto key = makeKey(mesh, npDirtyVertices | npDirtyNormals);
+    auto& m = m_mirror;
+    if (m.key != key || m.plane != plane || m.epsilon != epsilon) {
+        m.relation.resize_discard(mesh.num_vertices);
+        m.num_pairs = BuildMirroringRelation(m.relation.data(), mesh, plane, epsilon);
+        if (m.num_pairs < 0) {
+            m.key = SourceKey();
+            return nullptr;
+        }
+        m.key = key;
+        m.plane = plane;
+        m.epsilon = epsilon;
+    }
+    num_pairs = m.num_pairs;
+    return m.relation.data();
+}
+
+void npMeshContext::setTrackModified(bool v)
+{
+    if (v && !m_track_modified) {
+        // start from clean state
+        clearModified();
+    }
+    m_track_modified = v;
+}
+
+uint32_t* npMeshContext::getModifiedBits(const npMeshData& mesh)
+{
+    size_t num_words = ceildiv(mesh.num_vertices, 32);
+    if (m_modified.size() != num_words) {
+        // number of vertices has been changed. old bits are meaningless.
+        m_modified.resize(num_words);
+        m_modified.zeroclear();
+    }
+    return m_modified.data();
+}
+
+int npMeshContext::getModifiedIndices(int *dst) const
+{
+    if (!m_track_modified) { return 0; }
+
+    int ret = 0;
+    int num_words = (int)m_modified.size();
+    for (int wi = 0; wi < num_words; ++wi) {
+        uint32_t bits = m_modified[wi];
+        for (int bi = 0; bits != 0; ++bi, bits >>= 1) {
+            if (bits & 1) {
+                if (dst) { dst[ret] = wi * 32 + bi; }
+                ++ret;
+            }
+        }
+    }
+    return ret;
+}
+
+int npMeshContext::getModifiedRanges(int *dst) const
+{
+    if (!m_track_modified) { return 0; }
+
+    int ret = 0;
+    int begin = -1;
+    int num_bits = (int)m_modified.size() * 32;
+    for (int i = 0; i <= num_bits; ++i) {
+        if (i < num_bits && (i & 31) == 0 && begin == -1 && m_modified[i >> 5] == 0) {
+            // skip clean words
+            i += 31;
+            continue;
+        }
+        bool modified = i < num_bits && (m_modified[i >> 5] & (1u << (i & 31))) != 0;
+        if (modified && begin == -1) {
+            begin = i;
+        }
+        else if (!modified && begin != -1) {
+            if (dst) {
+                dst[ret * 2 + 0] = begin;
+                dst[ret * 2 + 1] = i;
+            }
+            ++ret;
+            begin = -1;
+        }
+    }
+    return ret;
+}
+
+void npMeshContext::clearModified()
+{
+    auto& g = m_grid;
+    if (g.key.vertices && g.key.vertex_version != m_vertex_version && !g.untracked) {
+        // the grid hasn't seen these modifications yet
+        if (!g.has_pending) {
+            g.pending.resize(m_modified.size());
+            g.pending.zeroclear();
+            g.has_pending = true;
+        }
+        for (size_t wi = 0; wi < m_modified.size(); ++wi) {
+            g.pending[wi] |= m_modified[wi];
+        }
+    }
+    m_modified.zeroclear();
+}
+
+const int* npMeshContext::findMirroringRelation(const npMeshData& mesh, const float3& plane, int *vertex_version) const
+{
+    auto& m = m_mirror;
+    if (m.key.vertices == nullptr || m.key.vertices != mesh.vertices || m.key.normals != mesh.normals ||
+        m.key.num_vertices != mesh.num_vertices || m.plane != plane)
+    {
+        return nullptr;
+    }
+    if (vertex_version) { *vertex_version = m.key.vertex_version; }
+    return m.relation.data();
+}
+
+
+const float3* GetTransformedVertices(const npMeshData& mesh, const float4x4& trans, ScratchVector<float3>& tmp)
+{
+    if (mesh.context) {
+        return mesh.context->getTransformedVertices(mesh, trans);
+    }
+    tmp.resize_discard(mesh.num_vertices);
+    TransformVertices(tmp.data(), mesh, trans);
+    return tmp.data();
+}
+
+const RawVector<float>* GetFlattenedTriangles(const npMeshData& mesh, const float4x4& trans, RawVector<float> (&tmp)[9])
+{
+    if (mesh.context) {
+        return mesh.context->getFlattenedTriangles(mesh, trans);
+    }
+    FlattenTriangles(tmp, mesh, trans);
+    return tmp;
+}
+
+const TriangleBVH& GetBVH(const npMeshData& mesh, TriangleBVH& tmp)
+{
+    if (mesh.context) {
+        return mesh.context->getBVH(mesh);
+    }
+    tmp.build(mesh.vertices, mesh.indices, mesh.num_triangles);
+    return tmp;
+}
+
+const SpatialHashGrid& GetVertexGrid(const npMeshData& mesh, SpatialHashGrid& tmp)
+{
+    if (mesh.context) {
+        return mesh.context->getVertexGrid(mesh);
+    }
+    tmp.build(mesh.vertices, mesh.num_vertices);
+    return tmp;
+}
+
+const ConnectionData& GetConnection(const npMeshData& mesh, ConnectionData& tmp)
+{
+    if (mesh.context) {
+        return mesh.context->getConnection(mesh);
+    }
+    BuildConnection(tmp, mesh);
+    return tmp;
+}
+
+const ConnectionData& GetWeldedConnection(const npMeshData& mesh, ConnectionData& tmp)
+{
+    if (mesh.context) {
+        return mesh.context->getWeldedConnection(mesh);
+    }
+    BuildConnection(tmp, mesh, true);
+    return tmp;
+}
+
+const npProjectedVertices& GetProjectedVertices(const npMeshData& mesh, const float4x4& mvp, npProjectedVertices& tmp)
+{
+    if (mesh.context) {
+        return mesh.context->getProjectedVertices(mesh, mvp);
+    }
+    tmp.build(mesh, mvp);
+    return tmp;
+}
+
+const int* GetMirroringRelation(const npMeshData& mesh, const float3& plane, float epsilon, RawVector<int>& tmp, int& num_pairs)
+{
+    if (mesh.context) {
+        return mesh.context->getMirroringRelation(mesh, plane, epsilon, num_pairs);
+    }
+    tmp.resize_discard(mesh.num_vertices);
+    num_pairs = BuildMirroringRelation(tmp.data(), mesh, plane, epsilon);
+    return num_pairs >= 0 ? tmp.data() : nullptr;
+}
+
+void MarkDirty(const npMeshData& mesh, int flags)
+{
+    if (mesh.context) {
+        mesh.context->markDirty(flags, true);
+    }
+}
+
+uint32_t* GetModifiedBits(const npMeshData& mesh)
+{
+    return mesh.context ? mesh.context->getModifiedBits(mesh) : nullptr;
+}
+
+
+npAPI npMeshContext* npCreateMeshContext()
+{
+    return new npMeshContext();
+}
+
+npAPI void npReleaseMeshContext(npMeshContext *ctx)
+{
+    delete ctx;
+}
+
+npAPI void npMeshContextMarkDirty(npMeshContext *ctx, int flags)
+{
+    if (ctx) {
+        ctx->markDirty(flags);
+    }
+}
+
+npAPI void npMeshContextSetTrackModified(npMeshContext *ctx, int v)
+{
+    if (ctx) {
+        ctx->setTrackModified(v != 0);
+    }
+}
+
+npAPI int npMeshContextGetModifiedIndices(npMeshContext *ctx, int *dst)
+{
+    return ctx ? ctx->getModifiedIndices(dst) : 0;
+}
+
+npAPI int npMeshContextGetModifiedRanges(npMeshContext *ctx, int *dst)
+{
+    return ctx ? ctx->getModifiedRanges(dst) : 0;
+}
+
+npAPI void npMeshContextClearModified(npMeshContext *ctx)
+{
+    if (ctx) {
+        ctx->clearModified();
+    }
+}
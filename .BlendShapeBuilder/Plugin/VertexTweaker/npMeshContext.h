@@ -0,0 +1,208 @@
+#pragma once
+
+enum npMeshDirtyFlags
+{
+    npDirtyVertices = 1,
+    npDirtyIndices  = 2,
+    npDirtyNormals  = 4,
+    npDirtyAll      = npDirtyVertices | npDirtyIndices | npDirtyNormals,
+};
+
+// vertices projected by mvp in SoA form (see ProjectPoints()) and a grid over them in normalized device coordinates.
+struct npProjectedVertices
+{
+    RawVector<float> x, y, z, w;
+    PointGrid2D grid;
+
+    void build(const npMeshData& mesh, const float4x4& mvp);
+    float2 getScreenPos(int vi) const { return { x[vi], y[vi] }; }
+    float4 getClipPos(int vi) const { return { x[vi] * w[vi], y[vi] * w[vi], z[vi], w[vi] }; }
+};
+
+// vertices in local space in SoA form (see Deinterleave()). lets selection and brushes process vertices with SIMD
+// (e.g. SelectInsideSoA()). the AoS buffer of npMeshData is the master. the mirror is rebuilt when it is modified,
+// unless the modifier updates the mirror along with it (see npMeshContext::validateVerticesSoA()).
+struct npVerticesSoA
+{
+    RawVector<float> x, y, z;
+
+    void build(const npMeshData& mesh);
+};
+
+// persistent per-mesh data that survives across API calls (set to npMeshData::context).
+// derived data (transformed vertices, flattened triangles, BVH) are built on demand and reused
+// until the version counters or the source buffers change.
+// the native API bumps the counters when it modifies the mesh. the caller must call
+// npMeshContextMarkDirty() when it modifies the buffers by itself.
+// getters are not thread safe. call them outside of parallel loops.
+struct npMeshContext
+{
+public:
+    // tracked: modified vertices have been recorded by MarkModified() (native API). otherwise any of vertices
+    // may have been modified and caches that are updated incrementally are fully updated.
+    void markDirty(int flags, bool tracked = false);
+    int getVertexVersion() const { return m_vertex_version; }
+    int getIndexVersion() const { return m_index_version; }
+    int getNormalVersion() const { return m_normal_version; }
+
+    // vertices transformed by trans
+    const float3* getTransformedVertices(const npMeshData& mesh, const float4x4& trans);
+    // triangles transformed by trans, flattened and SoA-nized. returns array of 9 (v1x, v1y, v1z, v2x, ... v3z)
+    const RawVector<float>* getFlattenedTriangles(const npMeshData& mesh, const float4x4& trans);
+    // BVH of triangles in local space
+    const TriangleBVH& getBVH(const npMeshData& mesh);
+    // SoA mirror of vertices
+    npVerticesSoA& getVerticesSoA(const npMeshData& mesh);
+    // marks the mirror up to date. call after markDirty() when the mirror has been modified along with vertices.
+    void validateVerticesSoA(const npMeshData& mesh);
+    // grid of vertices in local space. only vertices modified by the native API are relocated when updated.
+    const SpatialHashGrid& getVertexGrid(const npMeshData& mesh);
+    // vertex-to-face adjacency. depends only on indices.
+    const ConnectionData& getConnection(const npMeshData& mesh);
+    // same as getConnection() with vertices at the same position welded (weld_map etc. are valid). depends on vertices too.
+    const ConnectionData& getWeldedConnection(const npMeshData& mesh);
+    // mirroring relation of vertices (see npBuildMirroringRelation()). num_pairs receives the number of mirrored pairs.
+    // returns nullptr if the current job (see npJob) is cancelled while building.
+    const int* getMirroringRelation(const npMeshData& mesh, const float3& plane, float epsilon, int& num_pairs);
+    // vertices projected by mvp. useful when the camera and the mesh don't change during mouse moves.
+    const npProjectedVertices& getProjectedVertices(const npMeshData& mesh, const float4x4& mvp);
+
+    // tracking of vertices modified by the native API (any of positions, normals and tangents).
+    // lets the caller upload or snapshot only modified vertices. disabled by default.
+    // modified vertices are accumulated until clearModified().
+    void setTrackModified(bool v);
+    // bitset of modified vertices (bit vi % 32 of word vi / 32). see MarkModified().
+    // maintained even if tracking is disabled as the vertex grid depends on it. the queries below return 0 in that case.
+    uint32_t* getModifiedBits(const npMeshData& mesh);
+    // dst (optional) receives indices of modified vertices. returns the number of them.
+    int getModifiedIndices(int *dst) const;
+    // dst (optional) receives [begin, end) pairs of modified vertex ranges. returns the number of ranges.
+    int getModifiedRanges(int *dst) const;
+    void clearModified();
+
+    // relation last built for plane, or nullptr. unlike getMirroringRelation() modifications of vertices don't invalidate it,
+    // but the buffers and the number of vertices must be the same. vertex_version (optional) receives the vertex version
+    // the relation was built for (see getVertexVersion()).
+    const int* findMirroringRelation(const npMeshData& mesh, const float3& plane, int *vertex_version = nullptr) const;
+
+private:
+    // identifies source buffers and their versions
+    struct SourceKey
+    {
+        const void *vertices = nullptr;
+        const void *indices = nullptr;
+        const void *normals = nullptr;
+        int num_vertices = 0;
+        int num_triangles = 0;
+        int vertex_version = -1;
+        int index_version = -1;
+        int normal_version = -1;
+
+        bool operator==(const SourceKey& v) const
+        {
+            return vertices == v.vertices && indices == v.indices && normals == v.normals &&
+                num_vertices == v.num_vertices && num_triangles == v.num_triangles &&
+                vertex_version == v.vertex_version && index_version == v.index_version && normal_version == v.normal_version;
+        }
+        bool operator!=(const SourceKey& v) const { return !(*this == v); }
+    };
+    SourceKey makeKey(const npMeshData& mesh, int flags) const;
+
+    struct TransformedVertices
+    {
+        SourceKey key;
+        float4x4 trans;
+        RawVector<float3> data;
+        uint64_t last_used = 0;
+    };
+
+    struct FlattenedTriangles
+    {
+        SourceKey key;
+        float4x4 trans;
+        RawVector<float> soa[9];
+    };
+
+    struct BVHCache
+    {
+        SourceKey key;
+        TriangleBVH bvh;
+    };
+
+    struct SoACache
+    {
+        SourceKey key;
+        npVerticesSoA data;
+    };
+
+    struct GridCache
+    {
+        SourceKey key;
+        SpatialHashGrid grid;
+        bool untracked = false; // vertices have been modified by the caller
+        bool has_pending = false;
+        RawVector<uint32_t> pending; // modified bits cleared by clearModified() before the grid is updated
+    };
+
+    struct ConnectionCache
+    {
+        SourceKey key;
+        int num_vertices = 0;
+        ConnectionData connection;
+    };
+
+    struct ProjectedCache
+    {
+        SourceKey key;
+        float4x4 mvp;
+        npProjectedVertices data;
+    };
+
+    struct MirrorCache
+    {
+        SourceKey key; // vertices and normals
+        float3 plane = float3::zero();
+        float epsilon = 0.0f;
+        int num_pairs = 0;
+        RawVector<int> relation;
+    };
+
+    int m_vertex_version = 0;
+    int m_index_version = 0;
+    int m_normal_version = 0;
+    uint64_t m_tick = 0;
+    bool m_track_modified = false;
+    RawVector<uint32_t> m_modified;
+
+    // usually world space and local space of the model being edited
+    TransformedVertices m_transformed[2];
+    FlattenedTriangles m_flattened;
+    BVHCache m_bvh;
+    SoACache m_soa;
+    GridCache m_grid;
+    ConnectionCache m_connection;
+    ConnectionCache m_welded_connection;
+    ProjectedCache m_projected;
+    MirrorCache m_mirror;
+};
+
+// returns cached data if model has a context. otherwise build them into tmp.
+const float3* GetTransformedVertices(const npMeshData& mesh, const float4x4& trans, ScratchVector<float3>& tmp);
+const RawVector<float>* GetFlattenedTriangles(const npMeshData& mesh, const float4x4& trans, RawVector<float> (&tmp)[9]);
+const TriangleBVH& GetBVH(const npMeshData& mesh, TriangleBVH& tmp);
+const SpatialHashGrid& GetVertexGrid(const npMeshData& mesh, SpatialHashGrid& tmp);
+const ConnectionData& GetConnection(const npMeshData& mesh, ConnectionData& tmp);
+const ConnectionData& GetWeldedConnection(const npMeshData& mesh, ConnectionData& tmp);
+const npProjectedVertices& GetProjectedVertices(const npMeshData& mesh, const float4x4& mvp, npProjectedVertices& tmp);
+const int* GetMirroringRelation(const npMeshData& mesh, const float3& plane, float epsilon, RawVector<int>& tmp, int& num_pairs);
+void MarkDirty(const npMeshData& mesh, int flags);
+uint32_t* GetModifiedBits(const npMeshData& mesh);
+
+// bits: result of GetModifiedBits(). thread safe.
+inline void MarkModified(uint32_t *bits, int vi)
+{
+    if (bits) {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "");
+        reinterpret_cast<std::atomic<uint32_t>&>(bits[vi >> 5]).fetch_or(1u << (vi & 31), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "VertexTweaker.h"
+
+// compressed snapshots of vertices (see CompressedVertices). about half the size of float copies.
+// channels to capture are specified by PNT (1: points, 2: normals, 4: tangents). null buffers are omitted.
+npAPI CompressedVertices* npCreateSnapshot(npMeshData *model, int PNT)
+{
+    npProfileScope(model->num_vertices);
+    auto ret = new CompressedVertices();
+    ret->encode(
+        (PNT & 1) ? model->vertices : nullptr,
+        (PNT & 2) ? model->normals : nullptr,
+        (PNT & 4) ? model->tangents : nullptr,
+        model->num_vertices);
+    return ret;
+}
+
+// for deltas of blend shapes (see npGenerateBlendShapeDeltas()). null channels are omitted.
+npAPI CompressedVertices* npCreateDeltaSnapshot(
+    int num_vertices, const float3 *points, const float3 *normals, const float3 *tangents)
+{
+    npProfileScope(num_vertices);
+    auto ret = new CompressedVertices();
+    ret->encode(points, normals, tangents, num_vertices);
+    return ret;
+}
+
+npAPI void npReleaseSnapshot(CompressedVertices *snap)
+{
+    delete snap;
+}
+
+npAPI int npSnapshotGetNumVertices(const CompressedVertices *snap)
+{
+    return snap ? snap->num_vertices : 0;
+}
+
+// bytes of compressed data
+npAPI int npSnapshotGetMemorySize(const CompressedVertices *snap)
+{
+    return snap ? (int)snap->getMemorySize() : 0;
+}
+
+// buffers must have npSnapshotGetNumVertices() elements. null buffers and omitted channels are ignored.
+npAPI void npSnapshotGetData(const CompressedVertices *snap, float3 *points, float3 *normals, float4 *tangents)
+{
+    if (!snap) { return; }
+    npProfileScope(snap->num_vertices);
+    snap->decode(points, normals, tangents);
+}
+
+npAPI void npSnapshotGetDeltaData(const CompressedVertices *snap, float3 *points, float3 *normals, float3 *tangents)
+{
+    if (!snap) { return; }
+    npProfileScope(snap->num_vertices);
+    snap->decode(points, normals, tangents);
+}
+
+// write back captured channels to model. returns 0 if the number of vertices doesn't match.
+npAPI int npSnapshotRestore(const CompressedVertices *snap, npMeshData *model)
+{
+    if (!snap || snap->num_vertices != model->num_vertices) { return 0; }
+    npProfileScope(model->num_vertices);
+
+    snap->decode(model->vertices, model->normals, model->tangents);
+    if (model->vertices && !snap->points.empty()) {
+        MarkDirty(*model, npDirtyVertices);
+    }
+    if (model->normals && !snap->normals.empty()) {
+        MarkDirty(*model, npDirtyNormals);
+    }
+    if (auto modified = GetModifiedBits(*model)) {
+        parallel_for(0, model->num_vertices, [&](int vi) {
+            MarkModified(modified, vi);
+        });
+    }
+    return 1;
+}
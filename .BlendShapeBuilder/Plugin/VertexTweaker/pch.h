@@ -13,5 +13,9 @@
 #include <iostream>
 #include <sstream>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 #define npImpl
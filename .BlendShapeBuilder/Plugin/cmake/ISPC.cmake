@@ -3,6 +3,8 @@ include(CMakeParseArguments)
 option(ENABLE_ISPC "Use Intel ISPC to generate SIMDified code. It can significantly boost performance." ON)
 set(ISPC "/usr/local/bin/ispc" CACHE PATH "Path to Intel ISPC")
 mark_as_advanced(FORCE ISPC)
+# code is generated for each of these and the best one for the CPU is selected at runtime (see mu::GetSIMDTarget())
+set(ISPC_TARGETS "sse4-i32x4,avx1-i32x8,avx2-i32x8,avx512skx-i32x16" CACHE STRING "ISPC targets (comma separated)")
 
 function(setup_ispc)
     if(EXISTS ${ISPC})
@@ -45,16 +47,23 @@ function(add_ispc_targets)
         get_filename_component(name ${source} NAME_WE)
         set(header "${arg_OUTDIR}/${name}.h")
         set(object "${arg_OUTDIR}/${name}${CMAKE_CXX_OUTPUT_EXTENSION}")
-        set(objects 
-            ${object}
-            "${arg_OUTDIR}/${name}_sse4${CMAKE_CXX_OUTPUT_EXTENSION}"
-            "${arg_OUTDIR}/${name}_avx${CMAKE_CXX_OUTPUT_EXTENSION}"
-            "${arg_OUTDIR}/${name}_avx512skx${CMAKE_CXX_OUTPUT_EXTENSION}"
-        )
+        set(objects ${object})
+        # with multiple targets, ISPC emits an object per ISA (e.g. name_avx2.o) and the dispatcher in ${object}
+        string(REPLACE "," ";" targets ${ISPC_TARGETS})
+        list(LENGTH targets num_targets)
+        if(num_targets GREATER 1)
+            foreach(target ${targets})
+                string(REGEX REPLACE "-.*" "" isa ${target})
+                if(isa STREQUAL "avx1")
+                    set(isa "avx")
+                endif()
+                list(APPEND objects "${arg_OUTDIR}/${name}_${isa}${CMAKE_CXX_OUTPUT_EXTENSION}")
+            endforeach()
+        endif()
         set(outputs ${header} ${objects})
         add_custom_command(
             OUTPUT ${outputs}
-            COMMAND ${ISPC} ${source} -o ${object} -h ${header} --pic --target=sse4-i32x4,avx1-i32x8,avx512skx-i32x16 --arch=x86-64 --opt=fast-masked-vload --opt=fast-math --wno-perf
+            COMMAND ${ISPC} ${source} -o ${object} -h ${header} --pic --target=${ISPC_TARGETS} --arch=x86-64 --opt=fast-masked-vload --opt=fast-math --wno-perf
             DEPENDS ${source} ${arg_HEADERS}
         )
 
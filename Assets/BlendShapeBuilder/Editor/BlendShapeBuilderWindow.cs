@@ -2,6 +2,7 @@ using UnityEngine;
 using UnityEditor;
 using System;
 using System.Collections.Generic;
+using System.Runtime.InteropServices;
 using UTJ.VertexTweaker;
 using UTJ.BlendShapeBuilder;
 
@@ -604,6 +605,8 @@ namespace UTJ.BlendShapeBuilderEditor
 
             // add new blend shapes
             int numAdded = 0;
+            var sources = new List<DeltaSource>();
+            var deltaBuffers = new Vector3[DeltaBatchSize * 3][];
 
             // generate delta. * this must be before delete existing blend shapes *
             foreach (var shape in m_data.blendShapeData)
@@ -623,26 +626,23 @@ namespace UTJ.BlendShapeBuilderEditor
                     }
                     else
                     {
-                        if (frame.vertex)
-                            GenerateDelta(baseVertices, mesh.vertices, deltaVertices);
-                        else
-                            ZeroClear(deltaVertices);
-
-                        if (frame.normal)
-                            GenerateDelta(baseNormals, mesh.normals, deltaNormals);
-                        else
-                            ZeroClear(deltaNormals);
-
-                        if (frame.tangent)
-                            GenerateDelta(baseTangents, mesh.tangents, deltaTangents);
-                        else
-                            ZeroClear(deltaTangents);
-
-                        ret.AddBlendShapeFrame(name, frame.weight, deltaVertices, deltaNormals, deltaTangents);
-                        ++numAdded;
+                        sources.Add(new DeltaSource
+                        {
+                            name = name,
+                            weight = frame.weight,
+                            vertices = frame.vertex ? mesh.vertices : null,
+                            normals = frame.normal ? mesh.normals : null,
+                            tangents = frame.tangent ? mesh.tangents : null,
+                        });
+                        if (sources.Count == DeltaBatchSize)
+                        {
+                            numAdded += AddBlendShapeFrames(ret, baseVertices, baseNormals, baseTangents, sources, deltaBuffers);
+                            sources.Clear();
+                        }
                     }
                 }
             }
+            numAdded += AddBlendShapeFrames(ret, baseVertices, baseNormals, baseTangents, sources, deltaBuffers);
             Debug.Log("Done: added " + numAdded + " frames");
             return ret;
         }
@@ -701,27 +701,87 @@ namespace UTJ.BlendShapeBuilderEditor
             Undo.RegisterCreatedObjectUndo(frame.mesh, "BlendShapeBuilder");
         }
 
-        private static void ZeroClear(Vector3[] dst)
+        class DeltaSource
         {
-            int len = dst.Length;
-            var zero = Vector3.zero;
-            for (int i = 0; i < len; ++i)
-                dst[i] = zero;
+            public string name;
+            public float weight;
+            public Vector3[] vertices;
+            public Vector3[] normals;
+            public Vector4[] tangents;
         }
 
-        private static void GenerateDelta(Vector3[] from, Vector3[] to, Vector3[] dst)
-        {
-            var len = from.Length;
-            for (int i = 0; i < len; ++i)
-                dst[i] = to[i] - from[i];
-        }
+        // number of frames processed by one native call. bounds memory used by delta buffers.
+        const int DeltaBatchSize = 16;
 
-        private static void GenerateDelta(Vector4[] from, Vector4[] to, Vector3[] dst)
+        // deltas of all frames are generated in parallel by native plugin and written directly into deltaBuffers
+        static int AddBlendShapeFrames(Mesh dst, Vector3[] baseVertices, Vector3[] baseNormals, Vector4[] baseTangents,
+            List<DeltaSource> sources, Vector3[][] deltaBuffers)
         {
-            var len = from.Length;
-            for (int i = 0; i < len; ++i)
-                dst[i] = to[i] - from[i];
+            int numFrames = sources.Count;
+            int vertexCount = dst.vertexCount;
+            if (numFrames == 0)
+                return 0;
+
+            var handles = new List<GCHandle>();
+            Func<Array, IntPtr> pin = (a) =>
+            {
+                if (a == null || a.Length != vertexCount)
+                    return IntPtr.Zero;
+                var h = GCHandle.Alloc(a, GCHandleType.Pinned);
+                handles.Add(h);
+                return h.AddrOfPinnedObject();
+            };
+
+            var srcVertices = new IntPtr[numFrames];
+            var srcNormals = new IntPtr[numFrames];
+            var srcTangents = new IntPtr[numFrames];
+            var dstVertices = new IntPtr[numFrames];
+            var dstNormals = new IntPtr[numFrames];
+            var dstTangents = new IntPtr[numFrames];
+            try
+            {
+                for (int fi = 0; fi < numFrames; ++fi)
+                {
+                    var src = sources[fi];
+                    srcVertices[fi] = pin(src.vertices);
+                    srcNormals[fi] = pin(src.normals);
+                    srcTangents[fi] = pin(src.tangents);
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        int bi = fi * 3 + i;
+                        if (deltaBuffers[bi] == null || deltaBuffers[bi].Length != vertexCount)
+                            deltaBuffers[bi] = new Vector3[vertexCount];
+                    }
+                    dstVertices[fi] = pin(deltaBuffers[fi * 3 + 0]);
+                    dstNormals[fi] = pin(deltaBuffers[fi * 3 + 1]);
+                    dstTangents[fi] = pin(deltaBuffers[fi * 3 + 2]);
+                }
+
+                npGenerateBlendShapeDeltas(vertexCount, numFrames,
+                    pin(baseVertices), pin(baseNormals), pin(baseTangents),
+                    srcVertices, srcNormals, srcTangents,
+                    dstVertices, dstNormals, dstTangents);
+            }
+            finally
+            {
+                foreach (var h in handles)
+                    h.Free();
+            }
+
+            for (int fi = 0; fi < numFrames; ++fi)
+            {
+                var src = sources[fi];
+                dst.AddBlendShapeFrame(src.name, src.weight,
+                    deltaBuffers[fi * 3 + 0], deltaBuffers[fi * 3 + 1], deltaBuffers[fi * 3 + 2]);
+            }
+            return numFrames;
         }
+
+        [DllImport("VertexTweakerCore")] static extern int npGenerateBlendShapeDeltas(
+            int num_vertices, int num_frames,
+            IntPtr base_vertices, IntPtr base_normals, IntPtr base_tangents,
+            IntPtr[] vertices, IntPtr[] normals, IntPtr[] tangents,
+            IntPtr[] dst_vertices, IntPtr[] dst_normals, IntPtr[] dst_tangents);
         #endregion
 
     }
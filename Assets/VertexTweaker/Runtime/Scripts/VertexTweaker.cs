@@ -269,6 +269,10 @@ namespace UTJ.VertexTweaker
                 m_npModelData.tangents = m_tangents;
                 m_npModelData.uv = m_uv;
                 m_npModelData.selection = m_selection;
+                if (m_npModelData.context == IntPtr.Zero)
+                    m_npModelData.context = npCreateMeshContext();
+                else
+                    npMeshContextMarkDirty(m_npModelData.context, npMeshDirtyFlags.All);
 
                 var smr = GetComponent<SkinnedMeshRenderer>();
                 if (smr != null && smr.bones.Length > 0)
@@ -309,6 +313,11 @@ namespace UTJ.VertexTweaker
         void EndEdit()
         {
             ReleaseComputeBuffers();
+            if (m_npModelData.context != IntPtr.Zero)
+            {
+                npReleaseMeshContext(m_npModelData.context);
+                m_npModelData.context = IntPtr.Zero;
+            }
             if (Tools.current == Tool.None)
                 Tools.current = Tool.Move;
             m_editing = false;
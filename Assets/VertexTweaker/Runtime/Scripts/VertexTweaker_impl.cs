@@ -143,6 +143,21 @@ namespace UTJ.VertexTweaker
         ForwardAndBackward,
     };
 
+    public enum npTangentsMode
+    {
+        Fast,
+        MikkTSpace,
+    };
+
+    [Flags]
+    public enum npMeshDirtyFlags
+    {
+        Vertices = 1,
+        Indices = 2,
+        Normals = 4,
+        All = Vertices | Indices | Normals,
+    };
+
     public struct npMeshData
     {
         public IntPtr indices;
@@ -154,6 +169,7 @@ namespace UTJ.VertexTweaker
         public int num_vertices;
         public int num_triangles;
         public Matrix4x4 transform;
+        public IntPtr context;
     }
 
     public struct npSkinData
@@ -364,6 +380,8 @@ namespace UTJ.VertexTweaker
         {
             if (m_meshTarget == null) return;
 
+            npMeshContextMarkDirty(m_npModelData.context, npMeshDirtyFlags.Vertices);
+
             if (m_skinned)
             {
                 UpdateBoneMatrices();
@@ -506,7 +524,7 @@ namespace UTJ.VertexTweaker
                 npMeshData tmp = m_npModelData;
                 tmp.vertices = m_pointsPredeformed;
                 tmp.normals = m_normalsPredeformed;
-                npGenerateTangents(ref tmp, m_tangentsPredeformed);
+                npGenerateTangents(ref tmp, m_tangentsPredeformed, npTangentsMode.Fast);
             }
 
             if (m_skinned)
@@ -888,7 +906,11 @@ namespace UTJ.VertexTweaker
         [DllImport("VertexTweakerCore")] static extern int npGenerateNormals(
             ref npMeshData model, IntPtr dst);
         [DllImport("VertexTweakerCore")] static extern int npGenerateTangents(
-            ref npMeshData model, IntPtr dst);
+            ref npMeshData model, IntPtr dst, npTangentsMode mode);
+
+        [DllImport("VertexTweakerCore")] static extern IntPtr npCreateMeshContext();
+        [DllImport("VertexTweakerCore")] static extern void npReleaseMeshContext(IntPtr ctx);
+        [DllImport("VertexTweakerCore")] static extern void npMeshContextMarkDirty(IntPtr ctx, npMeshDirtyFlags flags);
 
         [DllImport("VertexTweakerCore")] static extern void npInitializePenInput();
         #endregion